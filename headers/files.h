@@ -19,4 +19,21 @@ Created on: Sep 29, 2010
 int    files_tokenizeStr(char *str, const char *delimiters, char ***tokens);
 char * files_readTextFile(char *filename);
 
+//Packed asset archive
+#define PACK_MAGIC		0x4b415041	//"APAK"
+#define PACK_VERSION	1
+#define PACK_ALIGN		64
+#define PACK_MAX_NAME	120
+#define MAX_PACK_FILES	4096
+
+//What's opened at startup unless another one is asked for
+#define PACK_DEFAULT	"assets.pak"
+
+eboolean     files_openPack(const char *packName);
+void         files_closePack();
+const byte * files_findAsset(const char *name, int *size);
+FILE *       files_openAsset(const char *name, const char *mode);
+const byte * files_loadAsset(const char *name, int *size, byte **allocated);
+eboolean     files_writePack(const char *packName, char **names, int numNames);
+
 #endif /* FILES_H_ */
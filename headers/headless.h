@@ -0,0 +1,24 @@
+/*
+===========================================================================
+File:		headless.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+//Offscreen GL context for running without a window, e.g. on a CPU-only
+//build machine with Mesa's llvmpipe. Renders into an EGL pbuffer, so it
+//needs linking against libEGL, but not a display server. Not built on
+//Windows, where headless_init just fails.
+
+eboolean headless_init(int width, int height);
+void     headless_shutdown();
+void *   headless_getProc(const char *name);
+
+double   headless_seconds();
+unsigned int headless_checksum(int width, int height);
+
+#endif /* HEADLESS_H_ */
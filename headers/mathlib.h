@@ -38,5 +38,8 @@ vec_t  VectorLength    (const vec3_t v);
 vec_t  VectorNormalize (const vec3_t in, vec3_t out);
 
 void glmatrix_identity(float *m);
+void glmatrix_multiply(const float *a, const float *b, float *out);
+void glmatrix_perspective(float fovy, float aspect, float zNear, float zFar, float *m);
+void glmatrix_frustumPlanes(const float *mvp, float planes[6][4]);
 
 #endif /* MATHLIB_H_ */
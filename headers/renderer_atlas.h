@@ -0,0 +1,50 @@
+/*
+===========================================================================
+File:		renderer_atlas.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_ATLAS_H_
+#define RENDERER_ATLAS_H_
+
+#define ATLAS_PAGE_SIZE		1024
+#define MAX_ATLAS_PAGES		8
+
+//Anything bigger than this keeps a texture of its own
+#define ATLAS_MAX_IMAGE		256
+
+//Edge pixels replicated around each image, so filtering at the border
+//doesn't pick up a neighbour
+#define ATLAS_PADDING		2
+
+#define MAX_SKYLINE_NODES	256
+
+typedef struct
+{
+	int x, y, width;
+}
+skylineNode_t;
+
+typedef struct
+{
+	int				width, height;
+	int				usedArea;
+	int				numNodes;
+	skylineNode_t	nodes[MAX_SKYLINE_NODES];
+}
+skyline_t;
+
+void     renderer_atlas_skylineInit(skyline_t *sky, int width, int height);
+eboolean renderer_atlas_skylineInsert(skyline_t *sky, int width, int height, int *x, int *y);
+
+void     renderer_atlas_blit(byte *dst, int dstWidth, const image_t *image, int x, int y,
+			int padding, eboolean bottomUp);
+
+//scaleOffset gets s scale, t scale, s offset, t offset for moving [0,1]
+//texture coordinates into the image's spot on the page
+eboolean renderer_atlas_addImage(const image_t *image, int *glTexID, float *scaleOffset);
+void     renderer_atlas_report();
+
+#endif /* RENDERER_ATLAS_H_ */
@@ -0,0 +1,85 @@
+/*
+===========================================================================
+File:		renderer_cmds.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_CMDS_H_
+#define RENDERER_CMDS_H_
+
+//Unlike most of the headers, this one pulls in the types its API is
+//built on
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_stream.h"
+#include "headers/renderer_mesh.h"
+
+#define MAX_CMD_RECORDERS	4
+#define MAX_RENDER_CMDS		4096
+#define MAX_RENDER_MATRICES	1024
+#define MAX_RENDER_VERTS	16384
+#define MAX_RENDER_INDIRECT	1024
+
+//Layers are executed in increasing order, everything inside of a layer is
+//sorted to minimize state changes.
+#define RL_BACKGROUND	0	//Sky meshes that get drawn first and cleared out of depth
+#define RL_WORLD		1
+#define RL_SKY			2	//Cube map sky, drawn after everything opaque
+#define RL_BLEND		3	//Translucent geom objects, back to front, no depth writes
+#define RL_OVERLAY		4	//Debug drawing on top of the scene, at window resolution, no depth test
+
+//Handle for "don't touch the modelview matrix"
+#define RC_NO_MATRIX -1
+
+//What renderer_cmd_loadMatrix hands back once the buffer is out of
+//matrices. Draws given it are dropped.
+#define RC_MATRIX_FULL -2
+
+//Draw flags
+#define RC_PREPASS	1	//Lay down depth first, so the real draw only shades visible pixels
+
+//View-space depth range covered by the sort key
+#define RC_SORT_FAR	1024.0
+
+typedef struct renderCmdBuffer_s renderCmdBuffer_t;
+
+//Game-side callback. Called once per recorder per frame, possibly from a
+//worker thread, so it must not touch GL.
+typedef void (*renderCmdRecordFunc_t)(int recorder, renderCmdBuffer_t *buf, const void *frameData);
+
+//GL-side callback for anything that isn't a plain model draw.
+typedef void (*renderCmdDrawFunc_t)(int arg);
+
+void renderer_cmd_init(int numRecorders, renderCmdRecordFunc_t recordFunc, int frameDataSize);
+void renderer_cmd_shutdown();
+void renderer_cmd_submitFrame(const void *frameData);
+
+int  renderer_cmd_loadMatrix(renderCmdBuffer_t *buf, const float *m);
+void renderer_cmd_clear(renderCmdBuffer_t *buf, int layer, int bits);
+void renderer_cmd_drawModel(renderCmdBuffer_t *buf, int layer, int matrix, int model,
+		float depth, int flags);
+void renderer_cmd_drawFunc(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		renderCmdDrawFunc_t func, int arg, float depth, int flags);
+
+streamVertex_t * renderer_cmd_allocVertices(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		GLenum mode, int numVerts, float depth);
+
+indirectCmd_t * renderer_cmd_allocIndirect(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		int count, float depth);
+
+float renderer_cmd_viewDepth(const float *modelview, const vec3_t mins, const vec3_t maxs);
+
+//Draw models, dynamic geometry and static meshes with the uber-shaders.
+//Only turn on if renderer_shader_init succeeded.
+void renderer_cmd_setShaders(eboolean enable, eboolean lit);
+
+//Debugging: counts shaded fragments in the stencil buffer
+void  renderer_cmd_setOverdraw(eboolean enable);
+float renderer_cmd_getOverdraw();
+
+#endif /* RENDERER_CMDS_H_ */
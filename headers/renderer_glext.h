@@ -0,0 +1,153 @@
+/*
+===========================================================================
+File:		renderer_glext.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_GLEXT_H_
+#define RENDERER_GLEXT_H_
+
+//Anything past GL 1.1 has to be fetched at runtime (opengl32.dll stops at
+//1.1), so it all goes through these pointers. Check glConfig before using
+//any of them.
+
+//The glext.h that comes with SDL stops well short of GL 3, so fill in what
+//we use from later versions
+#if !defined(GL_VERSION_3_2) && !defined(GL_ARB_sync)
+typedef struct __GLsync *GLsync;
+typedef long long GLint64;
+typedef unsigned long long GLuint64;
+#endif
+
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT				0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT			0x0040
+#define GL_MAP_COHERENT_BIT				0x0080
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER			0x8F3F
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER			0x88EC
+#endif
+#ifndef GL_DEPTH24_STENCIL8
+#define GL_DEPTH24_STENCIL8				0x88F0
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER				0x8A11
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT	0x8A34
+#define GL_INVALID_INDEX				0xFFFFFFFFu
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE	0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT		0x00000001
+#define GL_ALREADY_SIGNALED				0x911A
+#define GL_TIMEOUT_EXPIRED				0x911B
+#define GL_CONDITION_SATISFIED			0x911C
+#define GL_WAIT_FAILED					0x911D
+#endif
+
+typedef void *	(APIENTRY *qglMapBufferRange_t)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+typedef void	(APIENTRY *qglBufferStorage_t)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+typedef GLsync	(APIENTRY *qglFenceSync_t)(GLenum condition, GLbitfield flags);
+typedef GLenum	(APIENTRY *qglClientWaitSync_t)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void	(APIENTRY *qglDeleteSync_t)(GLsync sync);
+typedef GLuint	(APIENTRY *qglGetUniformBlockIndex_t)(GLuint program, const GLchar *name);
+typedef void	(APIENTRY *qglUniformBlockBinding_t)(GLuint program, GLuint blockIndex, GLuint binding);
+typedef void	(APIENTRY *qglBindBufferRange_t)(GLenum target, GLuint index, GLuint buffer,
+					GLintptr offset, GLsizeiptr size);
+typedef void	(APIENTRY *qglMultiDrawElementsIndirect_t)(GLenum mode, GLenum type, const void *indirect,
+					GLsizei drawcount, GLsizei stride);
+
+typedef struct
+{
+	int			versionMajor, versionMinor;
+	eboolean	vertexBufferObject;
+
+	//Buffer storage + map buffer range + sync, all three or nothing
+	eboolean	persistentMapping;
+
+	//Buffer objects as the source of texture uploads
+	eboolean	pixelBufferObject;
+
+	//Draws straight out of a buffer of DrawElementsIndirectCommands
+	eboolean	multiDrawIndirect;
+
+	//GLSL 1.40 and uniform buffers
+	eboolean	shaders;
+
+	//Render to texture, with a packed depth/stencil renderbuffer
+	eboolean	framebufferObject;
+
+	//GL_BGR/GL_BGRA pixel transfer formats
+	eboolean	bgra;
+
+	//DXT1/DXT5 textures, uploaded as they are
+	eboolean	textureCompressionS3TC;
+}
+glConfig_t;
+
+extern glConfig_t glConfig;
+
+//GL 1.5 / ARB_vertex_buffer_object
+extern PFNGLGENBUFFERSPROC		qglGenBuffers;
+extern PFNGLDELETEBUFFERSPROC	qglDeleteBuffers;
+extern PFNGLBINDBUFFERPROC		qglBindBuffer;
+extern PFNGLBUFFERDATAPROC		qglBufferData;
+extern PFNGLBUFFERSUBDATAPROC	qglBufferSubData;
+
+//GL 4.4 / ARB_buffer_storage, GL 3.0 / ARB_map_buffer_range, GL 3.2 / ARB_sync
+extern qglMapBufferRange_t		qglMapBufferRange;
+extern qglBufferStorage_t		qglBufferStorage;
+extern qglFenceSync_t			qglFenceSync;
+extern qglClientWaitSync_t		qglClientWaitSync;
+extern qglDeleteSync_t			qglDeleteSync;
+
+//GL 3.0 / ARB_framebuffer_object / EXT_framebuffer_object. The core and
+//EXT entry points are interchangeable for what we use them for.
+extern PFNGLGENFRAMEBUFFERSEXTPROC			qglGenFramebuffers;
+extern PFNGLDELETEFRAMEBUFFERSEXTPROC		qglDeleteFramebuffers;
+extern PFNGLBINDFRAMEBUFFEREXTPROC			qglBindFramebuffer;
+extern PFNGLFRAMEBUFFERTEXTURE2DEXTPROC		qglFramebufferTexture2D;
+extern PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC	qglCheckFramebufferStatus;
+extern PFNGLGENRENDERBUFFERSEXTPROC			qglGenRenderbuffers;
+extern PFNGLDELETERENDERBUFFERSEXTPROC		qglDeleteRenderbuffers;
+extern PFNGLBINDRENDERBUFFEREXTPROC			qglBindRenderbuffer;
+extern PFNGLRENDERBUFFERSTORAGEEXTPROC		qglRenderbufferStorage;
+extern PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC	qglFramebufferRenderbuffer;
+
+//GL 2.0 shaders, GL 3.1 uniform buffers
+extern PFNGLCREATESHADERPROC		qglCreateShader;
+extern PFNGLDELETESHADERPROC		qglDeleteShader;
+extern PFNGLSHADERSOURCEPROC		qglShaderSource;
+extern PFNGLCOMPILESHADERPROC		qglCompileShader;
+extern PFNGLGETSHADERIVPROC			qglGetShaderiv;
+extern PFNGLGETSHADERINFOLOGPROC	qglGetShaderInfoLog;
+extern PFNGLCREATEPROGRAMPROC		qglCreateProgram;
+extern PFNGLDELETEPROGRAMPROC		qglDeleteProgram;
+extern PFNGLATTACHSHADERPROC		qglAttachShader;
+extern PFNGLLINKPROGRAMPROC			qglLinkProgram;
+extern PFNGLGETPROGRAMIVPROC		qglGetProgramiv;
+extern PFNGLGETPROGRAMINFOLOGPROC	qglGetProgramInfoLog;
+extern PFNGLUSEPROGRAMPROC			qglUseProgram;
+extern qglGetUniformBlockIndex_t	qglGetUniformBlockIndex;
+extern qglUniformBlockBinding_t		qglUniformBlockBinding;
+extern qglBindBufferRange_t			qglBindBufferRange;
+
+//GL 4.3 / ARB_multi_draw_indirect
+extern qglMultiDrawElementsIndirect_t	qglMultiDrawElementsIndirect;
+
+//GL 1.3 / ARB_texture_compression
+extern PFNGLCOMPRESSEDTEXIMAGE2DPROC	qglCompressedTexImage2D;
+
+//Where the entry points come from. NULL means SDL_GL_GetProcAddress.
+typedef void * (*glGetProc_t)(const char *name);
+
+void     renderer_glext_init(glGetProc_t getProc);
+eboolean renderer_glext_hasExtension(const char *name);
+
+#endif /* RENDERER_GLEXT_H_ */
@@ -11,14 +11,188 @@ Created on: Feb 19, 2011
 
 #define MAX_TEXTURES 512
 
+//Buckets in the texture cache's hash table, a power of two
+#define TEXTURE_HASH_SIZE 1024
+
+#define NO_TEXTURE -1
+
+//Enough for a 32768x32768 base level
+#define MAX_IMAGE_LEVELS 16
+
+//Layout flags, for pixels left the way the file stored them
+#define IMAGE_BGR			1	//Blue first
+#define IMAGE_BOTTOM_UP		2	//Bottom row first
+#define IMAGE_MAPPED		4	//data is in the asset pack, not ours to free
+#define IMAGE_PACKED16		8	//To be uploaded as RGB5 or RGB5_A1
+
+//Decoded pixels, RGB or RGBA depending on bpp, top row first unless the
+//flags say otherwise. levels[0] is always data, anything after it is the
+//mip chain, each half the size of the one before (rounding down, never
+//below 1). If data points into a bigger allocation (the file it was read
+//from), block is that allocation.
+typedef struct
+{
+	int		width, height, bpp, flags;
+	byte	*data, *block;
+	int		numLevels;
+	byte	*levels[MAX_IMAGE_LEVELS];
+}
+image_t;
+
+//A loaded bitmap, shared by every material that uses it. If it's on an
+//atlas page, atlas is s scale, t scale, s offset, t offset. A streamed
+//texture only has levels baseLevel to numLevels - 1 in GL, baseLevel is
+//numLevels until the first of them arrive. format is the GL internal
+//format, and hash is of the pixels that went up (0 until they have).
+typedef struct
+{
+	int			glTexID, width, height, bpp;
+	eboolean	atlased;
+	float		atlas[4];
+
+	eboolean	streamed;
+	int			numLevels, baseLevel;
+
+	int				format;
+	unsigned int	hash;
+}
+texture_t;
+
 int renderer_img_createMaterial(char *name, vec3_t ambient, vec3_t diffuse, vec3_t specular,
-		float shine, float shineStrength, float transparency);
+		float shine, float shineStrength, float transparency, eboolean atlas);
 
 int renderer_img_getMatGLID(int i);
 int renderer_img_getMatWidth(int i);
 int renderer_img_getMatHeight(int i);
 int renderer_img_getMatBpp(int i);
+float renderer_img_getMatTransparency(int i);
+void renderer_img_getMatLighting(int i, vec3_t ambient, vec3_t diffuse, vec3_t specular, float *shine);
+void renderer_img_touchMaterial(int i);
+int renderer_img_getNumMaterials();
+int renderer_img_getMatTexture(int i);
+const char *renderer_img_getMatName(int i);
+void renderer_img_clearMaterials();
+eboolean renderer_img_getMatAtlas(int i, float *scaleOffset);
 
 void renderer_img_loadTGA(char *name, int *glTexID, int *width, int *height, int *bpp);
+eboolean renderer_img_uploadTGA(char *name, texture_t *texture);
+eboolean renderer_img_readTGA(char *name, image_t *image, eboolean native);
+eboolean renderer_img_peekTGA(char *name, int *width, int *height, int *bpp);
+eboolean renderer_img_decodeTGA(char *name, image_t *image);
+void renderer_img_freeImage(image_t *image);
+void renderer_img_genTexture(int numLevels, int *glTexID);
+void renderer_img_texParams(int numLevels);
+void renderer_img_uploadImage(const image_t *image, int *glTexID);
+void renderer_img_uploadLevels(const image_t *image, int firstLevel);
+int renderer_img_imageFormat(const image_t *image);
+void renderer_img_reportLoads();
+void renderer_img_setPacked16(eboolean enable);
+
+int renderer_img_acquireTexture(char *name, eboolean atlas);
+const texture_t *renderer_img_getTexture(int handle);
+void renderer_img_releaseTexture(int handle);
+void renderer_img_reportTextures();
+int renderer_img_getNumTextureHandles();
+const char *renderer_img_getTextureName(int handle);
+int renderer_img_getTextureUsers(int handle);
+
+//Texture streaming. With a budget set, textures start out with only their
+//levels up to STREAM_START_SIZE and get the rest once they're drawn,
+//taking them from whichever textures were drawn longest ago if that goes
+//over budget. Needs the loader running.
+#define STREAM_START_SIZE			64
+#define STREAM_REQUESTS_PER_FRAME	4
+
+//Frames a texture has to go undrawn before it can lose its finer levels
+#define STREAM_IDLE_FRAMES			30
+
+void renderer_img_setTextureBudget(int bytes);
+void renderer_img_touchTexture(int handle);
+void renderer_img_updateStreaming();
+void renderer_img_reportStreaming();
+
+void renderer_img_initMips();
+void renderer_img_buildMips(image_t *image);
+void renderer_img_shrinkImage(image_t *image, int steps);
+
+//Texture quality, for textures loaded after it's set. Below full, every
+//texture loses its finest one or two levels, and any still bigger than
+//the size cap either way loses as many more as it takes.
+#define TEXTURE_QUALITY_FULL	0
+#define TEXTURE_QUALITY_HALF	1
+#define TEXTURE_QUALITY_QUARTER	2
+#define TEXTURE_MAX_SIZE		4096
+
+void renderer_img_setQuality(int quality, int maxSize);
+int renderer_img_qualityByName(const char *name);
+int renderer_img_qualityLevels(int *width, int *height);
+void renderer_img_applyQuality(image_t *image);
+void renderer_img_countQuality(int fullBytes, int keptBytes);
+void renderer_img_reportQuality();
+
+//Texture memory, as uploaded. Atlased textures count their share of the
+//page. Duplicates are textures with the same pixels loaded from
+//different files, all but the first of them counted as wasted.
+#define MAX_STAT_FORMATS 8
+
+typedef struct
+{
+	int	numTextures, totalBytes, mipBytes;
+
+	int	numFormats;
+	int	formats[MAX_STAT_FORMATS], formatTextures[MAX_STAT_FORMATS], formatBytes[MAX_STAT_FORMATS];
+
+	int	numDuplicates, duplicateBytes;
+}
+textureStats_t;
+
+unsigned int renderer_img_hashBytes(const byte *data, int size);
+unsigned int renderer_img_hashImage(const image_t *image);
+int renderer_img_formatBytes(int format, int width, int height);
+const char *renderer_img_formatName(int format, eboolean atlased);
+int renderer_img_textureBytes(const texture_t *texture, int level);
+void renderer_img_getTextureStats(textureStats_t *stats);
+int renderer_img_getMaterialBytes(int i);
+void renderer_img_reportTextureStats();
+eboolean renderer_img_dumpTextureStats(const char *fileName);
+
+//BGR(A) to RGB(A) conversion paths, renderer_img_initSwizzle picks the
+//fastest one the CPU has
+#define SWIZZLE_SCALAR		0
+#define SWIZZLE_SSSE3		1
+#define SWIZZLE_AVX2		2
+#define MAX_SWIZZLE_PATHS	3
+
+void renderer_img_initSwizzle();
+eboolean renderer_img_setSwizzle(int path);
+const char *renderer_img_swizzleName(int path);
+void renderer_img_swizzleBGR(const byte *src, byte *dst, int width, int height, int comps, eboolean flip);
+
+//Block compression formats
+#define DXT_BC1 1	//DXT1, opaque
+#define DXT_BC3 2	//DXT5, interpolated alpha
+
+void renderer_img_initDXT();
+int renderer_img_dxtSize(int width, int height, int format);
+void renderer_img_encodeDXT(const byte *pixels, int width, int height, int comps, byte *out, int format);
+void renderer_img_decodeDXT(const byte *in, int width, int height, byte *pixels, int comps, int format);
+
+void renderer_img_setCookOnLoad(eboolean enable);
+eboolean renderer_img_cookImage(const image_t *image, char *cookedName);
+eboolean renderer_img_cookTGA(char *name);
+eboolean renderer_img_loadCooked(char *name, eboolean atlas, texture_t *texture);
+
+//Background loading. TGAs are decoded on worker threads into a staging
+//buffer, and the GL thread only copies them from there into the texture.
+#define LOADER_THREADS			2
+#define MAX_LOADER_THREADS		8
+#define LOADER_STAGING_BYTES	(16 * 1024 * 1024)
+
+void renderer_img_initLoader(int numThreads);
+void renderer_img_shutdownLoader();
+eboolean renderer_img_queueTGA(char *name, texture_t *texture, int firstLevel);
+void renderer_img_cancelLoad(int glTexID);
+eboolean renderer_img_updateLoads();
+eboolean renderer_img_flushLoads();
 
 #endif /* RENDERER_MATERIALS_H_ */
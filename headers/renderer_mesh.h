@@ -0,0 +1,37 @@
+/*
+===========================================================================
+File:		renderer_mesh.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_MESH_H_
+#define RENDERER_MESH_H_
+
+#define MAX_STATIC_MESHES	16
+#define MAX_MESH_IMAGES		16
+
+//Laid out as GL's DrawElementsIndirectCommand
+typedef struct
+{
+	GLuint	count, instanceCount, firstIndex;
+	GLint	baseVertex;
+	GLuint	baseInstance;
+}
+indirectCmd_t;
+
+//Quads are given as 4 vertices of s, t, x, y, z with texture coordinates
+//in [0,1] of that quad's own image. images has one entry per quad, the
+//same name may show up more than once.
+int  renderer_mesh_createStatic(int numQuads, const float *quads, char **images);
+void renderer_mesh_drawStatic(int index);
+int  renderer_mesh_getTexture(int index);
+
+//Shared buffers for every static mesh, built once they're all loaded
+void     renderer_mesh_buildShared();
+eboolean renderer_mesh_getIndirect(int index, indirectCmd_t *cmd);
+void     renderer_mesh_uploadIndirect(const indirectCmd_t *cmds, int count);
+void     renderer_mesh_drawIndirect(int first, int count);
+
+#endif /* RENDERER_MESH_H_ */
@@ -12,6 +12,18 @@ Created on: Feb 19, 2011
 #define MAX_MODELS   128
 
 void renderer_model_loadASE(char *name, eboolean collidable);
+void renderer_model_refreshTextures();
 void renderer_model_drawASE(int index);
+void renderer_model_drawObject(int index, int object);
+eboolean renderer_model_isObjectBlended(int index, int object);
+int  renderer_model_getObjectMaterial(int index, int object);
+void renderer_model_getBounds(int index, vec3_t mins, vec3_t maxs);
+int  renderer_model_getNumObjects(int index);
+int  renderer_model_getNumModels();
+const char *renderer_model_getName(int index);
+void renderer_model_getObjectBounds(int index, int object, vec3_t mins, vec3_t maxs);
+
+void renderer_model_setOccluder(int index, eboolean occluder);
+void renderer_model_drawOccluder(int index, const float *mvp);
 
 #endif /* RENDERER_MODELS_H_ */
@@ -0,0 +1,25 @@
+/*
+===========================================================================
+File:		renderer_occlusion.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_OCCLUSION_H_
+#define RENDERER_OCCLUSION_H_
+
+//Keep the width a multiple of 4, rows are processed 4 pixels at a time
+#define OCC_WIDTH	256
+#define OCC_HEIGHT	128
+
+void     renderer_occ_init();
+void     renderer_occ_clear();
+void     renderer_occ_drawMesh(const float *mvp, const float *verts, int numVerts,
+			const int *indices, int numTris);
+eboolean renderer_occ_testBox(const float *mvp, const vec3_t mins, const vec3_t maxs);
+
+const float * renderer_occ_getDepth();
+void     renderer_occ_getStats(int *tested, int *culled);
+
+#endif /* RENDERER_OCCLUSION_H_ */
@@ -0,0 +1,32 @@
+/*
+===========================================================================
+File:		renderer_scale.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_SCALE_H_
+#define RENDERER_SCALE_H_
+
+//Weight of the newest frame in the smoothed frame time
+#define SCALE_SMOOTHING		0.1
+
+//How far the smoothed frame time can drift from the target, as a
+//fraction of it, before the resolution changes
+#define SCALE_TOLERANCE		0.05
+
+//Frames to wait after a change, so the smoothed time can catch up
+#define SCALE_SETTLE_FRAMES	15
+
+eboolean renderer_scale_init(int width, int height, float minScale, float maxScale, float targetMs);
+void     renderer_scale_shutdown();
+void     renderer_scale_setEnabled(eboolean enable);
+
+void     renderer_scale_update(float frameMs);
+float    renderer_scale_getScale();
+
+void     renderer_scale_beginScene();
+void     renderer_scale_endScene();
+
+#endif /* RENDERER_SCALE_H_ */
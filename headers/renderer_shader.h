@@ -0,0 +1,39 @@
+/*
+===========================================================================
+File:		renderer_shader.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_SHADER_H_
+#define RENDERER_SHADER_H_
+
+//Feature bits. Every combination is compiled into its own program.
+#define SHADER_TEXTURED		1
+#define SHADER_VERTEX_COLOR	2	//Multiply in the per-vertex color
+#define SHADER_ALPHA		4	//Keep the material's opacity, otherwise alpha is 1
+#define SHADER_LIT			8	//Material ambient/diffuse/specular from one directional light
+#define MAX_SHADER_VARIANTS	16
+
+//Modelview matrices that can be uploaded in one frame. Enough for every
+//render command recorder's buffer to be full.
+#define MAX_SHADER_MATRICES	4096
+
+//White and fully opaque, for anything that isn't drawn with a material
+#define SHADER_NO_MATERIAL	-1
+
+eboolean renderer_shader_init();
+void     renderer_shader_shutdown();
+void     renderer_shader_buildMaterials();
+void     renderer_shader_setProjection(const float *projection);
+
+float *  renderer_shader_beginMatrices(int numMatrices);
+void     renderer_shader_endMatrices(int numMatrices);
+
+void     renderer_shader_bind(int features);
+void     renderer_shader_unbind();
+void     renderer_shader_setMatrix(int slot);
+void     renderer_shader_setMaterial(int material);
+
+#endif /* RENDERER_SHADER_H_ */
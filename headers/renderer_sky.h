@@ -0,0 +1,16 @@
+/*
+===========================================================================
+File:		renderer_sky.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_SKY_H_
+#define RENDERER_SKY_H_
+
+//Faces are given in GL order: +X, -X, +Y, -Y, +Z, -Z
+int  renderer_sky_loadCubemap(char *faces[6]);
+void renderer_sky_draw(int texture);
+
+#endif /* RENDERER_SKY_H_ */
@@ -0,0 +1,34 @@
+/*
+===========================================================================
+File:		renderer_stream.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef RENDERER_STREAM_H_
+#define RENDERER_STREAM_H_
+
+//Vertices one frame can stream, per segment
+#define STREAM_SEGMENT_VERTS	65536
+#define STREAM_SEGMENTS			3
+
+//Laid out for glInterleavedArrays(GL_T2F_C4UB_V3F)
+typedef struct
+{
+	float	st[2];
+	byte	rgba[4];
+	float	xyz[3];
+}
+streamVertex_t;
+
+void renderer_stream_init();
+void renderer_stream_shutdown();
+
+streamVertex_t * renderer_stream_begin(int numVerts);
+void renderer_stream_end(int numVerts);
+void renderer_stream_bind();
+void renderer_stream_unbind();
+void renderer_stream_endFrame();
+
+#endif /* RENDERER_STREAM_H_ */
@@ -0,0 +1,24 @@
+/*
+===========================================================================
+File:		simd.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef SIMD_H_
+#define SIMD_H_
+
+//We don't build with -msse & co. (the default mingw target doesn't have
+//it), so vector code paths are compiled per-function and only called
+//after checking SDL_HasSSE() and friends at runtime.
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#define SIMD_X86
+	#define SIMD_TARGET(isa) __attribute__((target(isa)))
+
+	//SDL 1.2 stops at SSE2, anything newer asks the compiler's cpuid
+	//wrapper. It also checks the OS saves the AVX registers.
+	#define SIMD_CPU_HAS(isa) __builtin_cpu_supports(isa)
+#endif
+
+#endif /* SIMD_H_ */
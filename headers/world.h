@@ -0,0 +1,30 @@
+/*
+===========================================================================
+File:		world.h
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#ifndef WORLD_H_
+#define WORLD_H_
+
+#define MAX_WORLD_OBJECTS	65536
+
+//For placed objects that aren't ASE geometry
+#define WORLD_NO_MODEL		-1
+
+int  world_addObject(const vec3_t mins, const vec3_t maxs, int model, int geomObject);
+void world_addModel(int model, const vec3_t origin);
+void world_moveObject(int handle, const vec3_t mins, const vec3_t maxs);
+void world_getObject(int handle, int *model, int *geomObject, vec3_t mins, vec3_t maxs);
+int  world_getNumObjects();
+
+void world_build();
+
+int  world_queryFrustum(const float *mvp, int *results, int maxResults);
+int  world_queryBox(const vec3_t mins, const vec3_t maxs, int *results, int maxResults);
+int  world_querySphere(const vec3_t center, float radius, int *results, int maxResults);
+int  world_queryNearest(const vec3_t point, float maxDist, float *dist);
+
+#endif /* WORLD_H_ */
@@ -12,19 +12,37 @@ Description:	Final project will include skybox, 3D models, and collision detecti
 #include "headers/SDL/SDL_main.h"
 #include "headers/SDL/SDL_opengl.h"
 #include "headers/common.h"
-#include "headers/renderer_models.h"
+#include "headers/files.h"
 #include "headers/mathlib.h"
-
+#include "headers/renderer_models.h"
+#include "headers/renderer_materials.h"
+#include "headers/renderer_atlas.h"
+#include "headers/renderer_stream.h"
+#include "headers/renderer_mesh.h"
+#include "headers/renderer_cmds.h"
+#include "headers/renderer_shader.h"
+#include "headers/renderer_scale.h"
+#include "headers/renderer_glext.h"
+#include "headers/renderer_occlusion.h"
+#include "headers/renderer_sky.h"
+#include "headers/world.h"
+#include "headers/headless.h"
+
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
 
 #define WINDOW_WIDTH  1024
 #define WINDOW_HEIGHT 768
 
 static int user_exit = 0;
 
+static int main_headless(int frames, char *timingsFile, eboolean checksum);
+static int main_benchSwizzle(int size, int iterations);
+static int main_cook(int numFiles, char **files);
+static int main_pack(int numArgs, char **args);
+
 //INPUT DECLARATIONS
 
 static void input_keyDown(SDLKey k);
@@ -43,40 +61,136 @@ typedef struct
 
 static camera_t camera;
 
+//Everything the render command recorders get to see. Copied every frame.
+typedef struct
+{
+	camera_t	camera;
+	eboolean	occlusion;
+	eboolean	prepass;
+	eboolean	bounds;
+	eboolean	indirect;
+} frameState_t;
+
 static void camera_init();
 static void camera_rotateX(float degree);
 static void camera_rotateY(float degree);
 static void camera_rotateZ(float degree);
 static void camera_translateForward(float dist);
 static void camera_translateStrafe(float dist);
+static void camera_followPath(float t);
 static void r_loadGameMeshes();
 
 //RENDERER DECLARATIONS
 
-//NEW TEXTURE STUFF
-static GLbyte* r_image_loadTGA(char *name, GLuint *glTexID, int *width, int *height, int *bpp, GLuint *type);
-
-static void r_init();
+static void r_init(glGetProc_t getProc);
 static void r_setupProjection();
-static void r_setupModelview();
+static void r_buildModelview(const camera_t *cam, eboolean translate, float *m);
+static void r_recordFrame(int recorder, renderCmdBuffer_t *buf, const void *frameData);
+static void r_recordCamera(renderCmdBuffer_t *buf, const frameState_t *frame);
+static void r_recordWorld(renderCmdBuffer_t *buf, const frameState_t *frame);
+static void r_recordBounds(renderCmdBuffer_t *buf, int matrix, const float *view,
+		const vec3_t mins, const vec3_t maxs, eboolean culled);
+static void r_recordIndirect(renderCmdBuffer_t *buf, int matrix, const int *meshes,
+		const float *depths, int count);
 static void r_drawFrame();
 
-//Texture Globals
-//My textures.
-static GLuint face1, face1Type;
-static int face1Width, face1Height, face1BPP;
-static GLuint face2, face2Type;
-static int face2Width, face2Height, face2BPP;
-static GLuint face3, face3Type;
-static int face3Width, face3Height, face3BPP;
-static GLuint face4, face4Type;
-static int face4Width, face4Height, face4BPP;
-static GLuint face5, face5Type;
-static int face5Width, face5Height, face5BPP;
-static GLuint face6, face6Type;
-static int face6Width, face6Height, face6BPP;
+//Number of threads recording render commands. 0 records on the main thread.
+//The first recorder does the sky and everything attached to the camera,
+//the second the placed objects and the occlusion culling they go through.
+//With fewer than two, the one recorder does both.
+#define R_NUM_RECORDERS 2
+#define R_WORLD_RECORDER (R_NUM_RECORDERS > 1 ? 1 : 0)
+
+//Projection, kept around on the CPU for culling
+static float projMatrix[16];
+
+//Toggled with 'o'
+static eboolean r_occlusion = etrue;
+
+//Depth pre-pass for the expensive stuff, toggled with 'p'
+static eboolean r_prepass = efalse;
 
-static GLbyte *face1data, *face2data, *face3data, *face4data, *face5data, *face6data;
+//Overdraw counting, toggled with 'v'
+static eboolean r_overdraw = efalse;
+
+//Bounding boxes of placed objects, toggled with 'b'. Green if drawn, red
+//if the occlusion test threw them out. Drawn over the top of everything.
+static eboolean r_bounds = efalse;
+
+//Static meshes go through the shared buffers and multi-draw indirect,
+//toggled with 'i'
+static eboolean r_indirect = efalse;
+
+//Uber-shaders instead of fixed function, toggled with 'g'. Lighting only
+//exists on the shader path, toggled with 'l'.
+static eboolean r_shaders = efalse;
+static eboolean r_lit = efalse;
+static eboolean r_shadersAvailable = efalse;
+
+//Dynamic resolution, toggled with 'u'. The scene is drawn at somewhere
+//between the two scales of the window size, whatever holds the target
+//frame time. Off unless a target is given.
+static eboolean r_dynamicRes = efalse;
+static float r_minScale = 0.5, r_maxScale = 1.0, r_targetMs = 0.0;
+
+//Cube map sky faces, +X, -X, +Y, -Y, +Z, -Z. If they can't be loaded we
+//fall back on the skybox model.
+static char *skyFaces[6] =
+{
+	"textures/sky_px.tga",
+	"textures/sky_nx.tga",
+	"textures/sky_py.tga",
+	"textures/sky_ny.tga",
+	"textures/sky_pz.tga",
+	"textures/sky_nz.tga"
+};
+
+static int r_skyCubemap = 0;
+
+//Threads decoding textures in the background, 0 to load them on the GL
+//thread
+static int r_loaderThreads = LOADER_THREADS;
+
+//Where the texture memory breakdown is written on the way out, if
+//anywhere. A name ending in .csv gets CSV.
+static char *r_texStatsFile = NULL;
+
+//What the world recorder collects each frame, grown to fit every placed
+//object. Only ever touched from that one recorder.
+static int		*r_visible = NULL, *r_drawMeshes = NULL;
+static float	*r_drawDepths = NULL;
+static int		r_visibleAllocated = 0;
+
+//Ids for placed objects that aren't ASE models
+#define R_PROP_CUBE 0
+
+//The textured cube, one quad per face: s, t, x, y, z
+static const float cubeFaces[6][4][5] =
+{
+	{ {0.0, 0.0, -0.5, -0.5, -8.0}, {1.0, 0.0,  0.5, -0.5, -8.0}, {1.0, 1.0,  0.5,  0.5, -8.0}, {0.0, 1.0, -0.5,  0.5, -8.0} },
+	{ {0.0, 0.0, -0.5, -0.5, -9.0}, {1.0, 0.0, -0.5, -0.5, -8.0}, {1.0, 1.0, -0.5,  0.5, -8.0}, {0.0, 1.0, -0.5,  0.5, -9.0} },
+	{ {0.0, 0.0,  0.5, -0.5, -8.0}, {1.0, 0.0,  0.5, -0.5, -9.0}, {1.0, 1.0,  0.5,  0.5, -9.0}, {0.0, 1.0,  0.5,  0.5, -8.0} },
+	{ {0.0, 0.0,  0.5, -0.5, -9.0}, {1.0, 0.0, -0.5, -0.5, -9.0}, {1.0, 1.0, -0.5,  0.5, -9.0}, {0.0, 1.0,  0.5,  0.5, -9.0} },
+	{ {0.0, 0.0, -0.5,  0.5, -8.0}, {1.0, 0.0,  0.5,  0.5, -8.0}, {1.0, 1.0,  0.5,  0.5, -9.0}, {0.0, 1.0, -0.5,  0.5, -9.0} },
+	{ {0.0, 0.0,  0.5, -0.5, -8.0}, {1.0, 0.0, -0.5, -0.5, -8.0}, {1.0, 1.0, -0.5, -0.5, -9.0}, {0.0, 1.0,  0.5, -0.5, -9.0} }
+};
+
+//Images for the cube, one per face in the same order as cubeFaces
+static char *cubeFaceImages[6] =
+{
+	"textures/face1.tga",
+	"textures/face4.tga",
+	"textures/face3.tga",
+	"textures/face6.tga",
+	"textures/face5.tga",
+	"textures/face2.tga"
+};
+
+static int r_cubeMesh = -1;
+
+//Bounds of the cube
+static const vec3_t cubeMins = { -0.5, -0.5, -9.0 };
+static const vec3_t cubeMaxs = {  0.5,  0.5, -8.0 };
 
 
 /*
@@ -86,6 +200,95 @@ static GLbyte *face1data, *face2data, *face3data, *face4data, *face5data, *face6
 int SDL_main(int argc, char* argv[]){
 	SDL_Event	event;
 	SDL_Surface	*screen;
+	int			i, headlessFrames, benchSize, quality, maxTexSize;
+	long		budget;
+	char		*timingsFile, *packName, *end;
+	eboolean	checksum;
+
+	headlessFrames	= 0;
+	benchSize		= 0;
+	timingsFile		= NULL;
+	packName		= PACK_DEFAULT;
+	checksum		= efalse;
+	quality			= TEXTURE_QUALITY_FULL;
+	maxTexSize		= TEXTURE_MAX_SIZE;
+
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "-headless") && i + 1 < argc)
+			headlessFrames = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-timings") && i + 1 < argc)
+			timingsFile = argv[++i];
+		else if(!strcmp(argv[i], "-checksum"))
+			checksum = etrue;
+		else if(!strcmp(argv[i], "-prepass"))
+			r_prepass = etrue;
+		else if(!strcmp(argv[i], "-overdraw"))
+			r_overdraw = etrue;
+		else if(!strcmp(argv[i], "-indirect"))
+			r_indirect = etrue;
+		else if(!strcmp(argv[i], "-shaders"))
+			r_shaders = etrue;
+		else if(!strcmp(argv[i], "-lit"))
+			r_lit = etrue;
+		else if(!strcmp(argv[i], "-dynres") && i + 1 < argc)
+			r_targetMs = atof(argv[++i]);
+		else if(!strcmp(argv[i], "-scale") && i + 2 < argc)
+		{
+			r_minScale = atof(argv[++i]);
+			r_maxScale = atof(argv[++i]);
+		}
+		else if(!strcmp(argv[i], "-benchswizzle"))
+			benchSize = (i + 1 < argc && argv[i + 1][0] != '-') ? atoi(argv[++i]) : 4096;
+		else if(!strcmp(argv[i], "-loaderthreads") && i + 1 < argc)
+			r_loaderThreads = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-texbudget") && i + 1 < argc)
+		{
+			//In MB, but the budget itself is in bytes and has to fit an int
+			budget = strtol(argv[++i], &end, 10);
+			if(*end != '\0' || budget < 0 || budget > INT_MAX / (1024 * 1024))
+			{
+				printf("Texture budget is 0 to %d MB, not %s\n", INT_MAX / (1024 * 1024), argv[i]);
+				return 1;
+			}
+
+			renderer_img_setTextureBudget((int)budget * 1024 * 1024);
+		}
+		else if(!strcmp(argv[i], "-quality") && i + 1 < argc)
+		{
+			quality = renderer_img_qualityByName(argv[++i]);
+			if(quality < 0)
+			{
+				printf("Texture quality is full, half or quarter, not %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if(!strcmp(argv[i], "-maxtexsize") && i + 1 < argc)
+			maxTexSize = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "-packed16"))
+			renderer_img_setPacked16(etrue);
+		else if(!strcmp(argv[i], "-texstats") && i + 1 < argc)
+			r_texStatsFile = argv[++i];
+		else if(!strcmp(argv[i], "-cookonload"))
+			renderer_img_setCookOnLoad(etrue);
+		else if(!strcmp(argv[i], "-cook"))
+			return main_cook(argc - i - 1, argv + i + 1);
+		else if(!strcmp(argv[i], "-pack"))
+			return main_pack(argc - i - 1, argv + i + 1);
+		else if(!strcmp(argv[i], "-archive") && i + 1 < argc)
+			packName = argv[++i];
+	}
+
+	if(benchSize > 0)
+		return main_benchSwizzle(benchSize, 20);
+
+	renderer_img_setQuality(quality, maxTexSize);
+
+	//Without an archive everything comes from loose files
+	files_openPack(packName);
+
+	if(headlessFrames > 0)
+		return main_headless(headlessFrames, timingsFile, checksum);
 
 	if(SDL_Init(SDL_INIT_VIDEO|SDL_INIT_TIMER) != 0)
 	{
@@ -96,6 +299,7 @@ int SDL_main(int argc, char* argv[]){
 	SDL_WM_SetCaption("Skybox Demo", "Skybox Demo");
 	SDL_ShowCursor(SDL_DISABLE);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 
 	screen = SDL_SetVideoMode(WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_OPENGL);
 	if(!screen)
@@ -104,12 +308,13 @@ int SDL_main(int argc, char* argv[]){
 		return 1;
 	}
 
-	r_init();
+	r_init(NULL);
 
 
 	//Declaration of variables used in decoupling.
 	int currTime = SDL_GetTicks();
 	int prevTime = 0;
+	int frameCount = 0;
 
 	//THIS IS THE GAME LOOP! *********************************************
 
@@ -139,15 +344,253 @@ int SDL_main(int argc, char* argv[]){
 		}
 
 		input_update(currTime - prevTime);
+		renderer_scale_update(currTime - prevTime);
 		r_drawFrame();
+
+		if(r_overdraw && (++frameCount % 64) == 0)
+			printf("Overdraw: %.2f shaded fragments per pixel\n", renderer_cmd_getOverdraw());
+
+		SDL_GL_SwapBuffers();
 	}
 
 	//********************************************************************
 
+	renderer_img_reportStreaming();
+	if(r_texStatsFile)
+		renderer_img_dumpTextureStats(r_texStatsFile);
+
+	renderer_cmd_shutdown();
+	renderer_img_clearMaterials();
+	renderer_img_shutdownLoader();
+	renderer_scale_shutdown();
+	renderer_shader_shutdown();
+	renderer_stream_shutdown();
+	files_closePack();
 	SDL_Quit();
 	return 0;
 }
 
+/*
+===========================================================================
+	HEADLESS
+===========================================================================
+*/
+
+static int main_compareTimes(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ * main_headless
+ * Renders a fixed number of frames along a fixed camera path into an
+ * offscreen buffer, timing each one. Run as: -headless <frames>
+ * [-timings <file>] [-checksum] [-prepass] [-overdraw] [-indirect]
+ * [-shaders] [-lit] [-dynres <target ms> [-scale <min> <max>]]
+ */
+static int main_headless(int frames, char *timingsFile, eboolean checksum)
+{
+	double	*times, *sorted, *scales, start, total, overdraw;
+	FILE	*file;
+	int		i;
+
+	if(SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		printf("Unable to initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	if(!headless_init(WINDOW_WIDTH, WINDOW_HEIGHT))
+	{
+		SDL_Quit();
+		return 1;
+	}
+
+	r_init(headless_getProc);
+	renderer_cmd_setOverdraw(r_overdraw);
+
+	times  = (double *)malloc(sizeof(double) * frames);
+	sorted = (double *)malloc(sizeof(double) * frames);
+	scales = (double *)malloc(sizeof(double) * frames);
+
+	overdraw = 0.0;
+
+	for(i = 0; i < frames; i++)
+	{
+		camera_followPath((float)i / frames);
+
+		start = headless_seconds();
+
+		//The scale a frame is drawn at is picked when it's submitted
+		scales[i] = renderer_scale_getScale();
+
+		r_drawFrame();
+		glFinish();
+
+		times[i] = (headless_seconds() - start) * 1000.0;
+		overdraw += renderer_cmd_getOverdraw();
+
+		renderer_scale_update(times[i]);
+	}
+
+	if(timingsFile != NULL)
+	{
+		file = fopen(timingsFile, "w");
+
+		if(file == NULL)
+			printf("Headless: could not write %s\n", timingsFile);
+		else
+		{
+			fprintf(file, "frame,ms,scale\n");
+			for(i = 0; i < frames; i++)
+				fprintf(file, "%d,%.3f,%.3f\n", i, times[i], scales[i]);
+			fclose(file);
+		}
+	}
+
+	memcpy(sorted, times, sizeof(double) * frames);
+	qsort(sorted, frames, sizeof(double), main_compareTimes);
+
+	for(i = 0, total = 0.0; i < frames; i++)
+		total += times[i];
+
+	printf("Headless: %d frames, avg %.3f ms, min %.3f, median %.3f, 95th %.3f, max %.3f\n",
+			frames, total / frames, sorted[0], sorted[frames / 2],
+			sorted[(frames * 95) / 100 < frames ? (frames * 95) / 100 : frames - 1], sorted[frames - 1]);
+
+	if(r_overdraw)
+		printf("Headless: %.3f shaded fragments per pixel, depth pre-pass %s\n",
+				overdraw / frames, r_prepass ? "on" : "off");
+
+	printf("Headless: static meshes drawn %s\n", r_indirect ? "indirect" : "one call each");
+	printf("Headless: %s\n", !r_shaders ? "fixed function" : r_lit ? "shaders, lit" : "shaders");
+
+	if(r_dynamicRes)
+	{
+		for(i = 0, total = 0.0; i < frames; i++)
+			total += scales[i];
+
+		printf("Headless: average resolution scale %.3f, last %.3f\n", total / frames, scales[frames - 1]);
+	}
+
+	renderer_img_reportStreaming();
+	if(r_texStatsFile)
+		renderer_img_dumpTextureStats(r_texStatsFile);
+
+	if(checksum)
+		printf("Headless: checksum %08x\n", headless_checksum(WINDOW_WIDTH, WINDOW_HEIGHT));
+
+	free(times);
+	free(sorted);
+	free(scales);
+
+	renderer_cmd_shutdown();
+	renderer_img_clearMaterials();
+	renderer_img_shutdownLoader();
+	renderer_scale_shutdown();
+	renderer_shader_shutdown();
+	renderer_stream_shutdown();
+	headless_shutdown();
+	files_closePack();
+	SDL_Quit();
+	return 0;
+}
+
+/*
+ * main_benchSwizzle
+ * Times every BGR(A) to RGB(A) path the CPU has on a size x size image,
+ * flipped the way a TGA is. Run as: -benchswizzle [size]
+ */
+static int main_benchSwizzle(int size, int iterations)
+{
+	byte	*src, *dst, *reference;
+	double	start, seconds, bytes;
+	int		path, comps, i, dataSize;
+
+	renderer_img_initSwizzle();
+
+	for(comps = 3; comps <= 4; comps++)
+	{
+		dataSize  = size * size * comps;
+		src		  = (byte *)malloc(dataSize);
+		dst		  = (byte *)malloc(dataSize);
+		reference = (byte *)malloc(dataSize);
+
+		for(i = 0; i < dataSize; i++)
+			src[i] = (byte)(i * 7 + (i >> 8));
+
+		renderer_img_setSwizzle(SWIZZLE_SCALAR);
+		renderer_img_swizzleBGR(src, reference, size, size, comps, etrue);
+
+		for(path = 0; path < MAX_SWIZZLE_PATHS; path++)
+		{
+			if(!renderer_img_setSwizzle(path))
+				continue;
+
+			//Once to fault the pages in
+			renderer_img_swizzleBGR(src, dst, size, size, comps, etrue);
+
+			start = headless_seconds();
+			for(i = 0; i < iterations; i++)
+				renderer_img_swizzleBGR(src, dst, size, size, comps, etrue);
+			seconds = headless_seconds() - start;
+
+			//Bytes read plus bytes written
+			bytes = 2.0 * dataSize * iterations;
+
+			printf("Swizzle: %dx%d %d bit, %-6s %6.2f GB/s%s\n", size, size, comps * 8,
+					renderer_img_swizzleName(path), bytes / seconds / 1e9,
+					memcmp(dst, reference, dataSize) ? ", MISMATCH" : "");
+		}
+
+		free(src);
+		free(dst);
+		free(reference);
+	}
+
+	renderer_img_initSwizzle();
+	return 0;
+}
+
+/*
+ * main_cook
+ * Writes a block compressed .dds next to every TGA given. Doesn't need a
+ * window. Run as: -cook <file.tga> [<file.tga> ...]
+ */
+static int main_cook(int numFiles, char **files)
+{
+	int i, failed;
+
+	renderer_img_initMips();
+	renderer_img_initSwizzle();
+	renderer_img_initDXT();
+
+	for(i = 0, failed = 0; i < numFiles; i++)
+		if(!renderer_img_cookTGA(files[i]))
+			failed++;
+
+	printf("Cooking: %d of %d textures cooked\n", numFiles - failed, numFiles);
+	return failed ? 1 : 0;
+}
+
+/*
+ * main_pack
+ * Builds an asset archive out of loose files, stored under the names
+ * they're given by. Run from the directory the game runs from, as:
+ * -pack <archive> <file> [<file> ...]
+ */
+static int main_pack(int numArgs, char **args)
+{
+	if(numArgs < 2)
+	{
+		printf("Pack: -pack <archive> <file> [<file> ...]\n");
+		return 1;
+	}
+
+	return files_writePack(args[0], args + 1, numArgs - 1) ? 0 : 1;
+}
+
 /*
 ===========================================================================
 	INPUT
@@ -156,7 +599,42 @@ int SDL_main(int argc, char* argv[]){
 
 static int keys_down[256];
 
-static void input_keyDown(SDLKey k) { keys_down[k] = 1; if(k == SDLK_ESCAPE || k == SDLK_q) user_exit = 1; }
+static void input_keyDown(SDLKey k)
+{
+	keys_down[k] = 1;
+
+	if(k == SDLK_ESCAPE || k == SDLK_q)
+		user_exit = 1;
+	else if(k == SDLK_o)
+		r_occlusion = !r_occlusion;
+	else if(k == SDLK_p)
+		r_prepass = !r_prepass;
+	else if(k == SDLK_b)
+		r_bounds = !r_bounds;
+	else if(k == SDLK_i)
+		r_indirect = !r_indirect;
+	else if(k == SDLK_g && r_shadersAvailable)
+	{
+		r_shaders = !r_shaders;
+		renderer_cmd_setShaders(r_shaders, r_lit);
+	}
+	else if(k == SDLK_u && r_targetMs > 0.0)
+	{
+		r_dynamicRes = !r_dynamicRes;
+		renderer_scale_setEnabled(r_dynamicRes);
+	}
+	else if(k == SDLK_l)
+	{
+		r_lit = !r_lit;
+		renderer_cmd_setShaders(r_shaders, r_lit);
+	}
+	else if(k == SDLK_v)
+	{
+		r_overdraw = !r_overdraw;
+		renderer_cmd_setOverdraw(r_overdraw);
+	}
+}
+
 static void input_keyUp  (SDLKey k) { keys_down[k] = 0; }
 
 /*
@@ -213,18 +691,24 @@ static void input_update(int delta)
 ===========================================================================
 */
 
-//Maintain a matrix for each rotation and one for translation
-static float xRotMatrix[16], yRotMatrix[16], zRotMatrix[16], translateMatrix[16];
-
 static void camera_init()
 {
 	VectorClear(camera.position);
 	VectorClear(camera.angles_deg);
 	VectorClear(camera.angles_rad);
-	glmatrix_identity(xRotMatrix);
-	glmatrix_identity(yRotMatrix);
-	glmatrix_identity(zRotMatrix);
-	glmatrix_identity(translateMatrix);
+}
+
+/*
+ * camera_followPath
+ * Fixed path for benchmarking, t goes from 0 to 1. A full turn on the
+ * spot, nodding up and down twice along the way.
+ */
+static void camera_followPath(float t)
+{
+	camera_init();
+
+	camera_rotateY(360.0 * t);
+	camera_rotateX(20.0 * sin(720.0 * M_PI_DIV180 * t));
 }
 
 //Rotations just increase/decrease the angle and compute a new radian value.
@@ -298,171 +782,6 @@ static void camera_translateStrafe(float dist)
 	camera.position[_Z] += dz;
 }
 
-/*
-===========================================================================
-	TGA LOADING
-===========================================================================
-*/
-
-#define HEADER_SIZE 18
-
-typedef struct
-{
-	unsigned char 	idLength, colormapType, imageType;
-	unsigned char	colormapSize;
-	unsigned short	colormapIndex, colormapLength;
-	unsigned short	xOrigin, yOrigin, width, height;
-	unsigned char	pixelSize, attributes;
-}
-tgaHeader_t;
-
-/*
- * Function: renderer_img_loadTGA
- * Description: Loads a TARGA image file, uploads to GL, and returns the
- * texture ID. Only supports 24/32 bit.
- */
-static GLbyte* r_image_loadTGA(char *name, GLuint *glTexID, int *width, int *height, int *bpp, GLuint *type)
-{
-	int				dataSize, rows, cols, i, j;
-	GLbyte			*buf, *imageData, *pixelBuf, red, green, blue, alpha;
-
-	FILE 			*file;
-	tgaHeader_t		header;
-	struct stat 	st;
-
-	file = fopen(name, "rb");
-
-	if(file == NULL)
-	{
-		printf("Loading TGA: %s, failed. Null file pointer.\n", name);
-		return NULL;
-	}
-
-	if(stat(name, &st))
-	{
-		printf("Loading TGA: %s, failed. Could not determine file size.\n", name);
-		return NULL;
-	}
-
-	if(st.st_size < HEADER_SIZE)
-	{
-		printf("Loading TGA: %s, failed. Header too short.\n", name);
-		return NULL;
-	}
-
-	buf = (byte *)malloc(st.st_size);
-	fread(buf, sizeof(byte), st.st_size, file);
-
-	fclose(file);
-
-	memcpy(&header.idLength, 	 	&buf[0],  1);
-	memcpy(&header.colormapType, 	&buf[1],  1);
-	memcpy(&header.imageType, 		&buf[2],  1);
-	memcpy(&header.colormapIndex, 	&buf[3],  2);
-	memcpy(&header.colormapLength,  &buf[5],  2);
-	memcpy(&header.colormapSize, 	&buf[7],  1);
-	memcpy(&header.xOrigin,			&buf[8],  2);
-	memcpy(&header.yOrigin,			&buf[10], 2);
-	memcpy(&header.width,			&buf[12], 2);
-	memcpy(&header.height,			&buf[14], 2);
-	memcpy(&header.pixelSize,		&buf[16], 1);
-	memcpy(&header.attributes,		&buf[17], 1);
-
-	//Advance past the header
-	buf += HEADER_SIZE;
-
-	if(header.pixelSize != 24 && header.pixelSize != 32)
-	{
-		printf("Loading TGA: %s, failed. Only support 24/32 bit images.\n", name);
-		return NULL;
-	}
-	else if(header.pixelSize == 24)
-		*type = GL_RGB;
-	else
-		*type = GL_RGBA;
-
-	//Determine size of image data chunk in bytes
-	dataSize = header.width * header.height * (header.pixelSize / 8);
-
-	//Set up our texture
-	*bpp 	 	= header.pixelSize;
-	*width  	= header.width;
-	*height 	= header.height;
-
-	imageData = (byte *)malloc(dataSize);
-	rows	  = *height;
-	cols	  = *width;
-
-	if(*type == GL_RGB)
-	{
-		for(i = 0; i < rows; i++)
-		{
-			pixelBuf = imageData + (i * cols * 3);
-			for(j = 0; j < cols; j++)
-			{
-				blue 	= *buf++;
-				green 	= *buf++;
-				red		= *buf++;
-
-				*pixelBuf++ = red;
-				*pixelBuf++ = green;
-				*pixelBuf++ = blue;
-			}
-		}
-	}
-	else
-	{
-		for(i = 0; i < rows; i++)
-		{
-			pixelBuf = imageData + (i * cols * 4);
-			for(j = 0; j < cols; j++)
-			{
-				blue 	= *buf++;
-				green 	= *buf++;
-				red		= *buf++;
-				alpha	= *buf++;
-
-				*pixelBuf++ = red;
-				*pixelBuf++ = green;
-				*pixelBuf++ = blue;
-				*pixelBuf++ = alpha;
-			}
-		}
-	}
-
-	//Upload the texture to OpenGL
-	glGenTextures(1, glTexID);
-	glBindTexture(GL_TEXTURE_2D, *glTexID);
-
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, type, *width, *height,
-			0, type, GL_UNSIGNED_BYTE, imageData);
-
-	//Header debugging
-	/*
-	printf("Attributes: %d\n", 				header.attributes);
-	printf("Colormap Index: %d\n", 			header.colormapIndex);
-	printf("Colormap Length: %d\n", 		header.colormapLength);
-	printf("Colormap Size: %d\n", 			header.colormapSize);
-	printf("Colormap Type: %d\n", 			header.colormapType);
-	printf("Height: %d\n", 					header.height);
-	printf("Identification Length: %d\n",	header.idLength);
-	printf("Image Type: %d\n", 				header.imageType);
-	printf("Pixel Size: %d\n", 				header.pixelSize);
-	printf("Width: %d\n", 					header.width);
-	printf("X Origin: %d\n", 				header.xOrigin);
-	printf("Y Origin: %d\n", 				header.yOrigin);
-	*/
-	return imageData;
-}
-
 /*
 ===========================================================================
 	RENDERER
@@ -473,7 +792,7 @@ static GLbyte* r_image_loadTGA(char *name, GLuint *glTexID, int *width, int *hei
  * r_init
  * Perform any one-time GL state changes.
  */
-static void r_init()
+static void r_init(glGetProc_t getProc)
 {
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
@@ -481,134 +800,47 @@ static void r_init()
 	//NEW TEXTURE STUFF
 	glEnable(GL_TEXTURE_2D);
 	//You might want to play with changing the modes
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-
-	//These functions load my custom textures.
-	//r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/uparrow.tga",
-	//		&myGLTexture, &myTexWidth, &myTexHeight, &myTexBPP);
-
-	//Testing
-	//"C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face1.tga"
-	face1data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face1.tga",
-			&face1, &face1Width, &face1Height, &face1BPP, &face1Type);
-	face2data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face2.tga",
-			&face2, &face2Width, &face2Height, &face2BPP, &face2Type);
-	face3data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face3.tga",
-			&face3, &face3Width, &face3Height, &face3BPP, &face3Type);
-	face4data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face4.tga",
-			&face4, &face4Width, &face4Height, &face4BPP, &face4Type);
-	face5data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face5.tga",
-			&face5, &face5Width, &face5Height, &face5BPP, &face5Type);
-	face6data = r_image_loadTGA("C:/Users/Cory/workspace/FunWithSDL/Debug/textures/face6.tga",
-			&face6, &face6Width, &face6Height, &face6BPP, &face6Type);
-
-
-	//*****************************************************************************
-		glGenTextures(1, &face1);
-		glBindTexture(GL_TEXTURE_2D, face1);
-
-		//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-		//mipmaps... without these calls texturing will not work properly.
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-		//Upload image data to OpenGL
-		glTexImage2D(GL_TEXTURE_2D, 0, face1Type, face1Width, face1Height,
-				0, face1Type, GL_UNSIGNED_BYTE, face1data);
-
-
-	//*****************************************************************************
-	glGenTextures(1, &face2);
-	glBindTexture(GL_TEXTURE_2D, face2);
-
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, face2Type, face2Width, face2Height,
-			0, face2Type, GL_UNSIGNED_BYTE, face2data);
-
-	//*************************************************************************
-	glGenTextures(1, &face3);
-	glBindTexture(GL_TEXTURE_2D, face3);
-
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, face3Type, face3Width, face3Height,
-		0, face3Type, GL_UNSIGNED_BYTE, face3data);
+	renderer_glext_init(getProc);
+	renderer_stream_init();
+	renderer_img_initLoader(r_loaderThreads);
 
-	//*************************************************************************
-	glGenTextures(1, &face4);
-	glBindTexture(GL_TEXTURE_2D, face4);
+	r_shadersAvailable = renderer_shader_init();
+	if(!r_shadersAvailable)
+		r_shaders = efalse;
 
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	renderer_img_initMips();
+	renderer_img_initSwizzle();
+	renderer_img_initDXT();
 
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, face4Type, face4Width, face4Height,
-		0, face4Type, GL_UNSIGNED_BYTE, face4data);
-
-	//*************************************************************************
-	glGenTextures(1, &face5);
-	glBindTexture(GL_TEXTURE_2D, face5);
-
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
-
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, face5Type, face5Width, face5Height,
-		0, face5Type, GL_UNSIGNED_BYTE, face5data);
-	//*************************************************************************
-	glGenTextures(1, &face6);
-	glBindTexture(GL_TEXTURE_2D, face6);
+	camera_init();
 
-	//Default OpenGL settings have GL_TEXTURE_MAG/MIN_FILTER set to use
-	//mipmaps... without these calls texturing will not work properly.
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	r_setupProjection();
+	r_loadGameMeshes();
 
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	//Everything loaded so far is needed for the first frame, so this is
+	//where the decoding on the loader threads gets waited for
+	if(renderer_img_flushLoads())
+		renderer_model_refreshTextures();
+	renderer_atlas_report();
+	renderer_img_reportLoads();
+	renderer_img_reportTextures();
+	renderer_img_reportQuality();
+	renderer_img_reportTextureStats();
+	renderer_shader_buildMaterials();
 
-	//Upload image data to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, face6Type, face6Width, face6Height,
-		0, face6Type, GL_UNSIGNED_BYTE, face6data);
+	r_skyCubemap = renderer_sky_loadCubemap(skyFaces);
 
-	camera_init();
+	renderer_occ_init();
+	renderer_cmd_init(R_NUM_RECORDERS, r_recordFrame, sizeof(frameState_t));
+	renderer_cmd_setShaders(r_shaders, r_lit);
 
-	r_setupProjection();
-	r_loadGameMeshes();
+	if(r_targetMs > 0.0)
+	{
+		r_dynamicRes = renderer_scale_init(WINDOW_WIDTH, WINDOW_HEIGHT, r_minScale, r_maxScale, r_targetMs);
+		renderer_scale_setEnabled(r_dynamicRes);
+	}
 }
 
 /*
@@ -617,220 +849,345 @@ static void r_init()
  */
 static void r_setupProjection()
 {
+	glmatrix_perspective(90.0, 1.33, 0.5, 1024.0, projMatrix);
+
 	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	gluPerspective(90.0, 1.33, 0.5, 1024.0);
+	glLoadMatrixf(projMatrix);
+
+	renderer_shader_setProjection(projMatrix);
 }
 
 /*
- * r_setupModelview
- * Calculates the GL modelview matrix. Called each frame.
+ * r_buildModelview
+ * Calculates the camera's modelview matrix on the CPU, so that it can be
+ * recorded off of the GL thread. The sky leaves out the translation.
  */
-static void r_setupModelview()
+static void r_buildModelview(const camera_t *cam, eboolean translate, float *m)
 {
+	float xRotMatrix[16], yRotMatrix[16], zRotMatrix[16], translateMatrix[16];
+	float xy[16], xyz[16];
 	float sinX, cosX, sinY, cosY, sinZ, cosZ;
 
-	sinX = sin(-camera.angles_rad[_X]);
-	cosX = cos(-camera.angles_rad[_X]);
+	glmatrix_identity(xRotMatrix);
+	glmatrix_identity(yRotMatrix);
+	glmatrix_identity(zRotMatrix);
+	glmatrix_identity(translateMatrix);
+
+	sinX = sin(-cam->angles_rad[_X]);
+	cosX = cos(-cam->angles_rad[_X]);
 
 	xRotMatrix[5]  = cosX;
 	xRotMatrix[6]  = sinX;
 	xRotMatrix[9]  = -sinX;
 	xRotMatrix[10] = cosX;
 
-	sinY = sin(-camera.angles_rad[_Y]);
-	cosY = cos(-camera.angles_rad[_Y]);
+	sinY = sin(-cam->angles_rad[_Y]);
+	cosY = cos(-cam->angles_rad[_Y]);
 
 	yRotMatrix[0]  =  cosY;
 	yRotMatrix[2]  = -sinY;
 	yRotMatrix[8]  =  sinY;
 	yRotMatrix[10] =  cosY;
 
-	sinZ = sin(-camera.angles_rad[_Z]);
-	cosZ = cos(-camera.angles_rad[_Z]);
+	sinZ = sin(-cam->angles_rad[_Z]);
+	cosZ = cos(-cam->angles_rad[_Z]);
 
 	zRotMatrix[0] = cosZ;
 	zRotMatrix[1] = sinZ;
 	zRotMatrix[4] = -sinZ;
 	zRotMatrix[5] = cosZ;
 
-	translateMatrix[12] = -camera.position[_X];
-	translateMatrix[13] = -camera.position[_Y];
-	translateMatrix[14] = -camera.position[_Z];
+	translateMatrix[12] = -cam->position[_X];
+	translateMatrix[13] = -cam->position[_Y];
+	translateMatrix[14] = -cam->position[_Z];
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	glMultMatrixf(xRotMatrix);
-	glMultMatrixf(yRotMatrix);
-	glMultMatrixf(zRotMatrix);
-	glMultMatrixf(translateMatrix);
+	glmatrix_multiply(xRotMatrix, yRotMatrix, xy);
+	glmatrix_multiply(xy, zRotMatrix, xyz);
+
+	if(translate)
+		glmatrix_multiply(xyz, translateMatrix, m);
+	else
+		memcpy(m, xyz, sizeof(float) * 16);
 }
 
-//r_setupModelviewforSky
-//Does same as above but without translation.
-static void r_setupModelviewforSky()
+/*
+ * r_loadGameMeshes
+ * Should allow the meshes to be loaded.
+ */
+static void r_loadGameMeshes(){
+	renderer_model_loadASE("models/skybox_stratosphere.ASE", efalse);
+	renderer_model_loadASE("models/fighter.ASE", efalse);
+
+	//The fighter sits right in front of the camera and hides a good chunk
+	//of the screen.
+	renderer_model_setOccluder(1, etrue);
+
+	//The sky and the fighter follow the camera around, only the cube is
+	//actually placed in the world.
+	r_cubeMesh = renderer_mesh_createStatic(6, &cubeFaces[0][0][0], cubeFaceImages);
+	renderer_mesh_buildShared();
+
+	world_addObject(cubeMins, cubeMaxs, WORLD_NO_MODEL, R_PROP_CUBE);
+	world_build();
+}
+
+/*
+===========================================================================
+	FRAME RECORDING
+===========================================================================
+*/
+
+/*
+ * r_recordFrame
+ * Records everything needed to draw one frame. Runs on a recorder thread,
+ * so no GL calls in here, only render commands. Each recorder gets its
+ * share of the frame, the GL thread sorts them back together.
+ */
+static void r_recordFrame(int recorder, renderCmdBuffer_t *buf, const void *frameData)
 {
-	float sinX, cosX, sinY, cosY, sinZ, cosZ;
+	const frameState_t *frame = (const frameState_t *)frameData;
 
-	sinX = sin(-camera.angles_rad[_X]);
-	cosX = cos(-camera.angles_rad[_X]);
+	if(recorder == 0)
+		r_recordCamera(buf, frame);
 
-	xRotMatrix[5]  = cosX;
-	xRotMatrix[6]  = sinX;
-	xRotMatrix[9]  = -sinX;
-	xRotMatrix[10] = cosX;
+	if(recorder == R_WORLD_RECORDER)
+		r_recordWorld(buf, frame);
+}
 
-	sinY = sin(-camera.angles_rad[_Y]);
-	cosY = cos(-camera.angles_rad[_Y]);
+/*
+ * r_recordCamera
+ * The clears, the sky and the fighter, everything that moves with the
+ * camera rather than being placed in the world.
+ */
+static void r_recordCamera(renderCmdBuffer_t *buf, const frameState_t *frame)
+{
+	float	m[16];
+	int		skyMatrix, fighterMatrix, flags;
+	vec3_t	mins, maxs;
 
-	yRotMatrix[0]  =  cosY;
-	yRotMatrix[2]  = -sinY;
-	yRotMatrix[8]  =  sinY;
-	yRotMatrix[10] =  cosY;
+	r_buildModelview(&frame->camera, efalse, m);
+	skyMatrix = renderer_cmd_loadMatrix(buf, m);
 
-	sinZ = sin(-camera.angles_rad[_Z]);
-	cosZ = cos(-camera.angles_rad[_Z]);
+	glmatrix_identity(m);
+	fighterMatrix = renderer_cmd_loadMatrix(buf, m);
 
-	zRotMatrix[0] = cosZ;
-	zRotMatrix[1] = sinZ;
-	zRotMatrix[4] = -sinZ;
-	zRotMatrix[5] = cosZ;
+	if(r_skyCubemap)
+	{
+		//The sky fills in every pixel that's left over, so there's no
+		//point in clearing color
+		renderer_cmd_clear(buf, RL_WORLD, GL_DEPTH_BUFFER_BIT);
+		renderer_cmd_drawFunc(buf, RL_SKY, skyMatrix, 0, renderer_sky_draw, r_skyCubemap, RC_SORT_FAR, 0);
+	}
+	else
+	{
+		renderer_cmd_clear(buf, RL_BACKGROUND, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		//Draw sky
+		renderer_cmd_drawModel(buf, RL_BACKGROUND, skyMatrix, 0, RC_SORT_FAR, 0);
+
+		//Throw away the sky's depth before drawing anything else
+		renderer_cmd_clear(buf, RL_WORLD, GL_DEPTH_BUFFER_BIT);
+	}
 
-	translateMatrix[12] = -camera.position[_X];
-	translateMatrix[13] = -camera.position[_Y];
-	translateMatrix[14] = -camera.position[_Z];
+	//The fighter is by far the heaviest thing on screen, so it's the one
+	//that gets the depth pre-pass
+	flags = frame->prepass ? RC_PREPASS : 0;
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	glMultMatrixf(xRotMatrix);
-	glMultMatrixf(yRotMatrix);
-	glMultMatrixf(zRotMatrix);
-	//glMultMatrixf(translateMatrix);
+	//Draw fighter. Needs to stay with the camera.
+	//Doesn't rotate. Only stays in the same position relative to camera.
+	renderer_model_getBounds(1, mins, maxs);
+	renderer_cmd_drawModel(buf, RL_WORLD, fighterMatrix, 1, renderer_cmd_viewDepth(m, mins, maxs), flags);
 }
 
 /*
- * r_loadGameMeshes
- * Should allow the meshes to be loaded.
+ * r_recordWorld
+ * Placed objects: frustum culled through the scene index, then tested
+ * against the occluders. The occlusion buffer isn't thread safe, so this
+ * is the only recorder that touches it.
  */
-static void r_loadGameMeshes(){
-	renderer_model_loadASE("C:/Users/Cory/workspace/FunWithSDL/Debug/models/skybox_stratosphere.ASE", efalse);
-	renderer_model_loadASE("C:/Users/Cory/workspace/FunWithSDL/Debug/models/fighter.ASE", efalse);
+static void r_recordWorld(renderCmdBuffer_t *buf, const frameState_t *frame)
+{
+	float			view[16], mvp[16], depth, *newDepths;
+	int				viewMatrix, i, numObjects, numVisible, numDraws, model, geomObject;
+	int				*newVisible, *newMeshes;
+	indirectCmd_t	indirect;
+	vec3_t			mins, maxs;
+
+	numObjects = world_getNumObjects();
+
+	//Whichever of these grew is kept, but only what all three can hold
+	//counts. Without the room, whatever doesn't fit just isn't drawn.
+	if(numObjects > r_visibleAllocated)
+	{
+		newVisible = (int *)realloc(r_visible, sizeof(int) * numObjects);
+		if(newVisible != NULL)
+			r_visible = newVisible;
+
+		newMeshes = (int *)realloc(r_drawMeshes, sizeof(int) * numObjects);
+		if(newMeshes != NULL)
+			r_drawMeshes = newMeshes;
+
+		newDepths = (float *)realloc(r_drawDepths, sizeof(float) * numObjects);
+		if(newDepths != NULL)
+			r_drawDepths = newDepths;
+
+		if(newVisible != NULL && newMeshes != NULL && newDepths != NULL)
+			r_visibleAllocated = numObjects;
+		else
+			printf("Out of memory for %d visible objects, keeping %d\n", numObjects, r_visibleAllocated);
+	}
+
+	r_buildModelview(&frame->camera, etrue, view);
+	viewMatrix = renderer_cmd_loadMatrix(buf, view);
+
+	//Software occlusion pass, before anything gets near GL. The fighter's
+	//modelview is the identity, so its MVP is just the projection.
+	if(frame->occlusion)
+	{
+		renderer_occ_clear();
+		renderer_model_drawOccluder(1, projMatrix);
+	}
+
+	glmatrix_multiply(projMatrix, view, mvp);
+	numVisible = world_queryFrustum(mvp, r_visible, r_visibleAllocated);
+	numDraws   = 0;
+
+	for(i = 0; i < numVisible; i++)
+	{
+		world_getObject(r_visible[i], &model, &geomObject, mins, maxs);
+
+		if(frame->occlusion && !renderer_occ_testBox(mvp, mins, maxs))
+		{
+			if(frame->bounds)
+				r_recordBounds(buf, viewMatrix, view, mins, maxs, etrue);
+
+			continue;
+		}
+
+		if(frame->bounds)
+			r_recordBounds(buf, viewMatrix, view, mins, maxs, efalse);
+
+		if(model == WORLD_NO_MODEL && geomObject == R_PROP_CUBE && r_cubeMesh >= 0)
+		{
+			depth = renderer_cmd_viewDepth(view, mins, maxs);
+
+			//Static meshes are already in world space, so they can all be
+			//batched up and drawn with the one view matrix
+			if(frame->indirect && renderer_mesh_getIndirect(r_cubeMesh, &indirect))
+			{
+				r_drawMeshes[numDraws]   = r_cubeMesh;
+				r_drawDepths[numDraws++] = depth;
+			}
+			else
+				renderer_cmd_drawFunc(buf, RL_WORLD, viewMatrix, renderer_mesh_getTexture(r_cubeMesh),
+						renderer_mesh_drawStatic, r_cubeMesh, depth, 0);
+		}
+	}
+
+	if(numDraws > 0)
+		r_recordIndirect(buf, viewMatrix, r_drawMeshes, r_drawDepths, numDraws);
 }
 
 /*
- * r_drawFrame
- * Perform any drawing and setup necessary to produce a single frame.
+ * r_recordIndirect
+ * One indirect draw per static mesh, covering every visible object that
+ * uses it. Each mesh has a single atlas texture, so that's also one draw
+ * per texture. Sorted by the nearest object in the batch.
  */
-static void r_drawFrame()
+static void r_recordIndirect(renderCmdBuffer_t *buf, int matrix, const int *meshes,
+		const float *depths, int count)
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	int				counts[MAX_STATIC_MESHES], i, mesh;
+	float			nearest[MAX_STATIC_MESHES];
+	indirectCmd_t	*cmds[MAX_STATIC_MESHES];
 
-	//Orient and position the camera
-	r_setupModelview();
+	memset(counts, 0, sizeof(counts));
 
-	//Draw sky?
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glPushMatrix();
-	glLoadIdentity();
-	r_setupModelviewforSky();
-	renderer_model_drawASE(0);
-	glPopMatrix();
+	for(i = 0; i < count; i++)
+	{
+		mesh = meshes[i];
 
+		if(counts[mesh]++ == 0 || depths[i] < nearest[mesh])
+			nearest[mesh] = depths[i];
+	}
 
-	glClear(GL_DEPTH_BUFFER_BIT);
+	for(mesh = 0; mesh < MAX_STATIC_MESHES; mesh++)
+	{
+		cmds[mesh] = NULL;
 
-	//Draw fighter. Needs to stay with the camera.
-	//Doesn't rotate. Only stays in the same position relative to camera.
-	glPushMatrix();
-	glLoadIdentity();
-	renderer_model_drawASE(1);
-	glPopMatrix();
-
-	//Texture stuff past this point.
-	glColor3f(1.0, 1.0, 1.0);
-
-
-	glBindTexture(GL_TEXTURE_2D, face1);
-	glBegin(GL_QUADS);
-		//Set up appropriate texture for the forward face.
-
-		//I've been visualizing this the wrong way. Each four is considered a square.
-		//Face 1
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(-0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f( 0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f( 0.5,  0.5, -8.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(-0.5,  0.5, -8.0);
-	glEnd();
-
-		//Face 2
-		glBindTexture(GL_TEXTURE_2D, face4);
-	glBegin(GL_QUADS);
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(-0.5, -0.5, -9.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f(-0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f(-0.5, 0.5, -8.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(-0.5, 0.5, -9.0);
-	glEnd();
-
-		//Face 3
-		glBindTexture(GL_TEXTURE_2D, face3);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f(0.5, -0.5, -9.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f(0.5, 0.5, -9.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(0.5, 0.5, -8.0);
-		glEnd();
-
-		//Face 4
-		glBindTexture(GL_TEXTURE_2D, face6);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(0.5, -0.5, -9.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f(-0.5, -0.5, -9.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f(-0.5, 0.5, -9.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(0.5, 0.5, -9.0);
-			glEnd();
-
-		//Face 5
-		glBindTexture(GL_TEXTURE_2D, face5);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(-0.5, 0.5, -8.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f(0.5, 0.5, -8.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f(0.5, 0.5, -9.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(-0.5, 0.5, -9.0);
-		glEnd();
-
-		//Face 6
-		glBindTexture(GL_TEXTURE_2D, face2);
-		glBegin(GL_QUADS);
-		glTexCoord2f(0.0, 0.0);
-			glVertex3f(0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 0.0);
-			glVertex3f(-0.5, -0.5, -8.0);
-		glTexCoord2f(1.0, 1.0);
-			glVertex3f(-0.5, -0.5, -9.0);
-		glTexCoord2f(0.0, 1.0);
-			glVertex3f(0.5, -0.5, -9.0);
-	glEnd();
-
-	SDL_GL_SwapBuffers();
+		if(counts[mesh] > 0)
+			cmds[mesh] = renderer_cmd_allocIndirect(buf, RL_WORLD, matrix, renderer_mesh_getTexture(mesh),
+					counts[mesh], nearest[mesh]);
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		mesh = meshes[i];
+
+		if(cmds[mesh] != NULL)
+			renderer_mesh_getIndirect(mesh, cmds[mesh]++);
+	}
+}
+
+/*
+ * r_recordBounds
+ * Outlines a box with streamed lines, for debugging the culling.
+ */
+static void r_recordBounds(renderCmdBuffer_t *buf, int matrix, const float *view,
+		const vec3_t mins, const vec3_t maxs, eboolean culled)
+{
+	//Corner index bits: 1 = max x, 2 = max y, 4 = max z
+	static const int edges[12][2] =
+	{
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+
+	streamVertex_t	*verts;
+	int				i, j, corner;
+
+	verts = renderer_cmd_allocVertices(buf, RL_OVERLAY, matrix, 0, GL_LINES, 24,
+			renderer_cmd_viewDepth(view, mins, maxs));
+
+	if(verts == NULL)
+		return;
+
+	for(i = 0; i < 12; i++)
+	{
+		for(j = 0; j < 2; j++, verts++)
+		{
+			corner = edges[i][j];
+
+			verts->st[0]   = verts->st[1] = 0.0;
+			verts->rgba[0] = culled ? 255 : 0;
+			verts->rgba[1] = culled ? 0 : 255;
+			verts->rgba[2] = 0;
+			verts->rgba[3] = 255;
+			verts->xyz[0]  = (corner & 1) ? maxs[0] : mins[0];
+			verts->xyz[1]  = (corner & 2) ? maxs[1] : mins[1];
+			verts->xyz[2]  = (corner & 4) ? maxs[2] : mins[2];
+		}
+	}
+}
+
+/*
+ * r_drawFrame
+ * Hands the current camera off to the recorders and submits the last
+ * recorded frame. Presenting it is up to the caller.
+ */
+static void r_drawFrame()
+{
+	frameState_t frame;
+
+	frame.camera	= camera;
+	frame.occlusion	= r_occlusion;
+	frame.prepass	= r_prepass;
+	frame.bounds	= r_bounds;
+	frame.indirect	= r_indirect;
+
+	if(renderer_img_updateLoads())
+		renderer_model_refreshTextures();
+	renderer_img_updateStreaming();
+	renderer_cmd_submitFrame(&frame);
 }
@@ -70,3 +70,58 @@ void glmatrix_identity(float *m)
 		else
 			m[i] = 0.0;
 }
+
+/*
+ * glmatrix_multiply
+ * Computes out = a * b for column-major matrices, i.e. the same result as
+ * loading a and then calling glMultMatrixf(b). out may not alias a or b.
+ */
+void glmatrix_multiply(const float *a, const float *b, float *out)
+{
+	int row, col;
+
+	for(col = 0; col < 4; col++)
+		for(row = 0; row < 4; row++)
+			out[col*4+row] = a[0*4+row]*b[col*4+0] + a[1*4+row]*b[col*4+1] +
+							 a[2*4+row]*b[col*4+2] + a[3*4+row]*b[col*4+3];
+}
+
+/*
+ * glmatrix_perspective
+ * Same matrix gluPerspective would multiply onto the stack.
+ */
+void glmatrix_perspective(float fovy, float aspect, float zNear, float zFar, float *m)
+{
+	float f = 1.0 / tan(fovy * M_PI_DIV180 / 2.0);
+
+	glmatrix_identity(m);
+
+	m[0]  = f / aspect;
+	m[5]  = f;
+	m[10] = (zFar + zNear) / (zNear - zFar);
+	m[11] = -1.0;
+	m[14] = (2.0 * zFar * zNear) / (zNear - zFar);
+	m[15] = 0.0;
+}
+
+/*
+ * glmatrix_frustumPlanes
+ * Pulls the six clip planes (left, right, bottom, top, near, far) out of a
+ * projection * modelview matrix. A point is inside of a plane when
+ * a*x + b*y + c*z + d >= 0. The planes are not normalized.
+ */
+void glmatrix_frustumPlanes(const float *mvp, float planes[6][4])
+{
+	int i;
+
+	for(i = 0; i < 4; i++)
+	{
+		//mvp is column-major, so row j is mvp[j], mvp[4+j], ...
+		planes[0][i] = mvp[i*4+3] + mvp[i*4+0];
+		planes[1][i] = mvp[i*4+3] - mvp[i*4+0];
+		planes[2][i] = mvp[i*4+3] + mvp[i*4+1];
+		planes[3][i] = mvp[i*4+3] - mvp[i*4+1];
+		planes[4][i] = mvp[i*4+3] + mvp[i*4+2];
+		planes[5][i] = mvp[i*4+3] - mvp[i*4+2];
+	}
+}
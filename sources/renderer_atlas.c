@@ -0,0 +1,300 @@
+/*
+===========================================================================
+File:		renderer_atlas.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Skyline bottom-left packing. Small material images share
+			pages, so a model built out of lots of little bitmaps binds
+			one texture instead of one per geom object.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_materials.h"
+#include "headers/renderer_atlas.h"
+
+#include <limits.h>
+
+typedef struct
+{
+	skyline_t	sky;
+	GLuint		texture;
+	int			numImages;
+}
+atlasPage_t;
+
+static atlasPage_t pages[MAX_ATLAS_PAGES];
+static int numPages = 0;
+
+/*
+ * renderer_atlas_skylineInit
+ */
+void renderer_atlas_skylineInit(skyline_t *sky, int width, int height)
+{
+	sky->width	  = width;
+	sky->height	  = height;
+	sky->usedArea = 0;
+
+	sky->numNodes		= 1;
+	sky->nodes[0].x		= 0;
+	sky->nodes[0].y		= 0;
+	sky->nodes[0].width = width;
+}
+
+/*
+ * skyline_fit
+ * Returns the lowest y a rectangle can sit at with its left edge on the
+ * given node, or -1 if it doesn't fit there.
+ */
+static int skyline_fit(const skyline_t *sky, int index, int width, int height)
+{
+	int i, y, left;
+
+	if(sky->nodes[index].x + width > sky->width)
+		return -1;
+
+	y	 = 0;
+	left = width;
+
+	for(i = index; left > 0; i++)
+	{
+		if(sky->nodes[i].y > y)
+			y = sky->nodes[i].y;
+
+		if(y + height > sky->height)
+			return -1;
+
+		left -= sky->nodes[i].width;
+	}
+
+	return y;
+}
+
+/*
+ * renderer_atlas_skylineInsert
+ * Places a rectangle where its top ends up lowest, narrowest node first on
+ * ties. Returns efalse if it doesn't fit anywhere.
+ */
+eboolean renderer_atlas_skylineInsert(skyline_t *sky, int width, int height, int *x, int *y)
+{
+	int i, fit, best, bestTop, bestWidth, shrink;
+
+	best	  = -1;
+	bestTop	  = INT_MAX;
+	bestWidth = INT_MAX;
+
+	for(i = 0; i < sky->numNodes; i++)
+	{
+		fit = skyline_fit(sky, i, width, height);
+
+		if(fit < 0)
+			continue;
+
+		if(fit + height < bestTop || (fit + height == bestTop && sky->nodes[i].width < bestWidth))
+		{
+			best	  = i;
+			bestTop	  = fit + height;
+			bestWidth = sky->nodes[i].width;
+		}
+	}
+
+	if(best < 0 || sky->numNodes >= MAX_SKYLINE_NODES)
+		return efalse;
+
+	*x = sky->nodes[best].x;
+	*y = bestTop - height;
+
+	//The new rectangle becomes a node of its own...
+	memmove(&sky->nodes[best + 1], &sky->nodes[best], sizeof(skylineNode_t) * (sky->numNodes - best));
+	sky->numNodes++;
+
+	sky->nodes[best].x	   = *x;
+	sky->nodes[best].y	   = bestTop;
+	sky->nodes[best].width = width;
+
+	//...and eats into whatever it covers to the right
+	for(i = best + 1; i < sky->numNodes; )
+	{
+		shrink = sky->nodes[i - 1].x + sky->nodes[i - 1].width - sky->nodes[i].x;
+
+		if(shrink <= 0)
+			break;
+
+		sky->nodes[i].x		+= shrink;
+		sky->nodes[i].width -= shrink;
+
+		if(sky->nodes[i].width > 0)
+			break;
+
+		memmove(&sky->nodes[i], &sky->nodes[i + 1], sizeof(skylineNode_t) * (sky->numNodes - i - 1));
+		sky->numNodes--;
+	}
+
+	//Merge neighbours at the same height
+	for(i = 0; i < sky->numNodes - 1; )
+	{
+		if(sky->nodes[i].y == sky->nodes[i + 1].y)
+		{
+			sky->nodes[i].width += sky->nodes[i + 1].width;
+			memmove(&sky->nodes[i + 1], &sky->nodes[i + 2], sizeof(skylineNode_t) * (sky->numNodes - i - 2));
+			sky->numNodes--;
+		}
+		else
+			i++;
+	}
+
+	sky->usedArea += width * height;
+	return etrue;
+}
+
+/*
+ * renderer_atlas_blit
+ * Copies an image into an RGBA buffer with its top left at (x, y), and
+ * smears the outer pixels across the padding. With bottomUp the image's
+ * bottom row goes first, so that t = 0 is the bottom of the image.
+ */
+void renderer_atlas_blit(byte *dst, int dstWidth, const image_t *image, int x, int y,
+		int padding, eboolean bottomUp)
+{
+	int			i, j, sx, sy, comps;
+	byte		*out;
+	const byte	*src;
+
+	comps = image->bpp / 8;
+
+	for(j = -padding; j < image->height + padding; j++)
+	{
+		sy = j < 0 ? 0 : (j >= image->height ? image->height - 1 : j);
+
+		//Decoded images are top row first
+		if(bottomUp)
+			sy = image->height - 1 - sy;
+
+		src = image->data + sy * image->width * comps;
+		out = dst + ((y + j) * dstWidth + x - padding) * 4;
+
+		for(i = -padding; i < image->width + padding; i++, out += 4)
+		{
+			sx = i < 0 ? 0 : (i >= image->width ? image->width - 1 : i);
+
+			out[0] = src[sx * comps + 0];
+			out[1] = src[sx * comps + 1];
+			out[2] = src[sx * comps + 2];
+			out[3] = (comps == 4) ? src[sx * comps + 3] : 255;
+		}
+	}
+}
+
+/*
+ * atlas_newPage
+ */
+static atlasPage_t * atlas_newPage()
+{
+	atlasPage_t *page;
+
+	if(numPages >= MAX_ATLAS_PAGES)
+		return NULL;
+
+	page = &pages[numPages++];
+
+	renderer_atlas_skylineInit(&page->sky, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+	page->numImages = 0;
+
+	glGenTextures(1, &page->texture);
+	glBindTexture(GL_TEXTURE_2D, page->texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE,
+			0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	return page;
+}
+
+/*
+ * renderer_atlas_addImage
+ * Finds the image a spot on one of the pages and uploads it there. Only
+ * for images whose texture coordinates stay within [0,1], the pages don't
+ * repeat. Returns efalse if the image should get a texture of its own.
+ */
+eboolean renderer_atlas_addImage(const image_t *image, int *glTexID, float *scaleOffset)
+{
+	int			i, x, y, width, height;
+	atlasPage_t	*page;
+	byte		*padded;
+
+	if(image->width > ATLAS_MAX_IMAGE || image->height > ATLAS_MAX_IMAGE)
+		return efalse;
+
+	width  = image->width  + ATLAS_PADDING * 2;
+	height = image->height + ATLAS_PADDING * 2;
+
+	page = NULL;
+	for(i = 0; i < numPages; i++)
+	{
+		if(renderer_atlas_skylineInsert(&pages[i].sky, width, height, &x, &y))
+		{
+			page = &pages[i];
+			break;
+		}
+	}
+
+	if(page == NULL)
+	{
+		page = atlas_newPage();
+
+		if(page == NULL || !renderer_atlas_skylineInsert(&page->sky, width, height, &x, &y))
+			return efalse;
+	}
+
+	padded = (byte *)malloc(width * height * 4);
+	renderer_atlas_blit(padded, width, image, ATLAS_PADDING, ATLAS_PADDING, ATLAS_PADDING, efalse);
+
+	glBindTexture(GL_TEXTURE_2D, page->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, padded);
+
+	free(padded);
+
+	page->numImages++;
+
+	*glTexID = page->texture;
+
+	scaleOffset[0] = (float)image->width  / ATLAS_PAGE_SIZE;
+	scaleOffset[1] = (float)image->height / ATLAS_PAGE_SIZE;
+	scaleOffset[2] = (float)(x + ATLAS_PADDING) / ATLAS_PAGE_SIZE;
+	scaleOffset[3] = (float)(y + ATLAS_PADDING) / ATLAS_PAGE_SIZE;
+
+	return etrue;
+}
+
+/*
+ * renderer_atlas_report
+ * Prints how full each page is. Padding counts as used.
+ */
+void renderer_atlas_report()
+{
+	int i, images, used;
+
+	images = used = 0;
+
+	for(i = 0; i < numPages; i++)
+	{
+		printf("Atlas page %d: %d images, %.1f%% used\n", i, pages[i].numImages,
+				100.0 * pages[i].sky.usedArea / (ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE));
+
+		images += pages[i].numImages;
+		used   += pages[i].sky.usedArea;
+	}
+
+	if(numPages > 0)
+		printf("Atlas: %d images on %d pages, %.1f%% used overall\n", images, numPages,
+				100.0 * used / ((float)numPages * ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE));
+}
@@ -0,0 +1,1055 @@
+/*
+===========================================================================
+File:		renderer_cmds.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Render command buffers. Game-side code records draws into a
+			per-recorder buffer (one per thread), and the GL thread sorts
+			and executes them. Frames are double-buffered, so while the GL
+			thread is submitting frame N the recorders are already filling
+			in frame N+1.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+#include "headers/SDL/SDL_thread.h"
+#include "headers/SDL/SDL_mutex.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_models.h"
+#include "headers/renderer_stream.h"
+#include "headers/renderer_mesh.h"
+#include "headers/renderer_shader.h"
+#include "headers/renderer_scale.h"
+#include "headers/renderer_cmds.h"
+
+typedef enum { RC_CLEAR, RC_DRAW_MODEL, RC_DRAW_OBJECT, RC_DRAW_FUNC, RC_DRAW_VERTS, RC_DRAW_INDIRECT } renderCmdType_t;
+
+//Passes inside of a layer. Clears always come first, then depth-only
+//copies of anything flagged RC_PREPASS, then the real draws, then the
+//translucent geom objects of models drawn outside of RL_WORLD.
+typedef enum { RP_CLEAR, RP_DEPTH, RP_COLOR, RP_BLEND } renderPass_t;
+
+typedef struct
+{
+	Uint64				key;
+	renderCmdType_t		type;
+	const float			*matrix;
+
+	//Index of the matrix in its buffer, then in the frame's shader upload
+	int					matrixSlot;
+	int					texture, arg, object;
+	renderCmdDrawFunc_t	func;
+
+	//RC_DRAW_VERTS: GL primitive, first vertex in the buffer, and count.
+	//RC_DRAW_INDIRECT: first indirect command in the buffer, and count.
+	GLenum				mode;
+	int					first, count;
+}
+renderCmd_t;
+
+struct renderCmdBuffer_s
+{
+	int				numCmds, numMatrices, numVerts, numIndirect;
+	renderCmd_t		cmds[MAX_RENDER_CMDS];
+	float			matrices[MAX_RENDER_MATRICES][16];
+	streamVertex_t	verts[MAX_RENDER_VERTS];
+	indirectCmd_t	indirect[MAX_RENDER_INDIRECT];
+};
+
+typedef struct
+{
+	renderCmdBuffer_t	buffers[MAX_CMD_RECORDERS];
+	byte				*frameData;
+}
+renderFrame_t;
+
+static void renderer_cmd_kick(const void *frameData);
+static void renderer_cmd_execute(renderFrame_t *frame);
+static int  renderer_cmd_recorderThread(void *data);
+static void renderer_cmd_setPass(int from, int to);
+static void renderer_cmd_setLayer(int from, int to);
+static void renderer_cmd_endScene();
+static void renderer_cmd_beginOverdraw();
+static void renderer_cmd_endOverdraw();
+static void renderer_cmd_beginBlend();
+static int  renderer_cmd_shaderFeatures(const renderCmd_t *cmd, int layer, int pass, int current);
+static void renderer_cmd_setMaterial(int material, int *current);
+
+static renderFrame_t	frames[2];
+static renderCmd_t		*sortedCmds[MAX_CMD_RECORDERS * MAX_RENDER_CMDS];
+static indirectCmd_t	indirectCmds[MAX_CMD_RECORDERS * MAX_RENDER_INDIRECT];
+
+static renderCmdRecordFunc_t	recordFunc;
+static int						numRecorders, frameDataSize;
+static int						recorderIDs[MAX_CMD_RECORDERS];
+
+static SDL_Thread		*recorderThreads[MAX_CMD_RECORDERS];
+static SDL_sem			*recordStart[MAX_CMD_RECORDERS], *recordDone;
+static volatile int		shuttingDown;
+
+//Index of the frame the recorders are (or were last) working on
+static volatile int		kickedFrame;
+static eboolean			framePending = efalse;
+
+//Overdraw debugging
+static eboolean			overdraw = efalse;
+static float			overdrawRatio = 0.0;
+
+//Uber-shaders instead of fixed function
+static eboolean			shaders = efalse, shadersLit = efalse;
+
+/*
+ * renderer_cmd_init
+ * numRecorders == 0 records inline on the calling thread, which keeps
+ * everything single threaded and without the extra frame of latency.
+ */
+void renderer_cmd_init(int recorders, renderCmdRecordFunc_t func, int dataSize)
+{
+	int i;
+
+	if(recorders > MAX_CMD_RECORDERS)
+		recorders = MAX_CMD_RECORDERS;
+
+	numRecorders	= recorders;
+	recordFunc		= func;
+	frameDataSize	= dataSize;
+	shuttingDown	= 0;
+
+	for(i = 0; i < 2; i++)
+		frames[i].frameData = (byte *)malloc(dataSize > 0 ? dataSize : 1);
+
+	if(numRecorders == 0)
+		return;
+
+	recordDone = SDL_CreateSemaphore(0);
+
+	for(i = 0; i < numRecorders; i++)
+	{
+		recorderIDs[i]		= i;
+		recordStart[i]		= SDL_CreateSemaphore(0);
+		recorderThreads[i]	= SDL_CreateThread(renderer_cmd_recorderThread, &recorderIDs[i]);
+	}
+}
+
+/*
+ * renderer_cmd_shutdown
+ */
+void renderer_cmd_shutdown()
+{
+	int i;
+
+	if(numRecorders > 0)
+	{
+		//Let any in-flight frame finish before pulling the rug out
+		if(framePending)
+			for(i = 0; i < numRecorders; i++)
+				SDL_SemWait(recordDone);
+
+		shuttingDown = 1;
+
+		for(i = 0; i < numRecorders; i++)
+		{
+			SDL_SemPost(recordStart[i]);
+			SDL_WaitThread(recorderThreads[i], NULL);
+			SDL_DestroySemaphore(recordStart[i]);
+		}
+
+		SDL_DestroySemaphore(recordDone);
+	}
+
+	for(i = 0; i < 2; i++)
+		free(frames[i].frameData);
+
+	framePending = efalse;
+	numRecorders = 0;
+}
+
+/*
+ * renderer_cmd_submitFrame
+ * Called once per frame from the GL thread. frameData is a snapshot of
+ * whatever the recorders need (camera, etc.) and is copied, so the caller
+ * is free to keep modifying its own copy.
+ */
+void renderer_cmd_submitFrame(const void *frameData)
+{
+	int i, done;
+
+	if(numRecorders == 0)
+	{
+		kickedFrame = 0;
+		memcpy(frames[0].frameData, frameData, frameDataSize);
+		frames[0].buffers[0].numCmds = frames[0].buffers[0].numMatrices = 0;
+		frames[0].buffers[0].numVerts = frames[0].buffers[0].numIndirect = 0;
+
+		recordFunc(0, &(frames[0].buffers[0]), frames[0].frameData);
+		renderer_cmd_execute(&frames[0]);
+		return;
+	}
+
+	//Nothing in flight on the very first frame, so get one going
+	if(!framePending)
+		renderer_cmd_kick(frameData);
+
+	for(i = 0; i < numRecorders; i++)
+		SDL_SemWait(recordDone);
+
+	//Start recording the next frame before we submit this one
+	done = kickedFrame;
+	renderer_cmd_kick(frameData);
+
+	renderer_cmd_execute(&frames[done]);
+}
+
+/*
+ * renderer_cmd_kick
+ * Resets the other frame's buffers and wakes up the recorders.
+ */
+static void renderer_cmd_kick(const void *frameData)
+{
+	int				i, next;
+	renderFrame_t	*frame;
+
+	next  = framePending ? !kickedFrame : 0;
+	frame = &frames[next];
+
+	memcpy(frame->frameData, frameData, frameDataSize);
+
+	for(i = 0; i < numRecorders; i++)
+	{
+		frame->buffers[i].numCmds = frame->buffers[i].numMatrices = 0;
+		frame->buffers[i].numVerts = frame->buffers[i].numIndirect = 0;
+	}
+
+	kickedFrame	 = next;
+	framePending = etrue;
+
+	for(i = 0; i < numRecorders; i++)
+		SDL_SemPost(recordStart[i]);
+}
+
+/*
+ * renderer_cmd_recorderThread
+ */
+static int renderer_cmd_recorderThread(void *data)
+{
+	int				recorder = *(int *)data;
+	renderFrame_t	*frame;
+
+	for(;;)
+	{
+		SDL_SemWait(recordStart[recorder]);
+
+		if(shuttingDown)
+			break;
+
+		frame = &frames[kickedFrame];
+		recordFunc(recorder, &(frame->buffers[recorder]), frame->frameData);
+
+		SDL_SemPost(recordDone);
+	}
+
+	return 0;
+}
+
+/*
+===========================================================================
+Recording
+===========================================================================
+*/
+
+//Sort keys: | layer (8) | pass (4) | depth (16) | texture (16) | sequence (20) |
+//Front to back inside of a pass, ties go to whoever shares a texture.
+#define RC_KEY(layer, pass, depth, texture, seq) \
+	(((Uint64)((layer) & 0xFF) << 56) | ((Uint64)((pass) & 0xF) << 52) | \
+	((Uint64)((depth) & 0xFFFF) << 36) | ((Uint64)((texture) & 0xFFFF) << 20) | (Uint64)((seq) & 0xFFFFF))
+
+/*
+ * renderer_cmd_quantizeDepth
+ * Translucent draws go back to front, so their depth is flipped.
+ */
+static int renderer_cmd_quantizeDepth(int layer, renderPass_t pass, float depth)
+{
+	if(layer == RL_BLEND || pass == RP_BLEND)
+		depth = RC_SORT_FAR - depth;
+
+	if(depth <= 0.0)
+		return 0;
+	if(depth >= RC_SORT_FAR)
+		return 0xFFFF;
+
+	return (int)(depth * (0xFFFF / RC_SORT_FAR));
+}
+
+/*
+ * renderer_cmd_alloc
+ * Returns NULL (and complains once) if the buffer is full, or if the
+ * matrix never made it in.
+ */
+static renderCmd_t * renderer_cmd_alloc(renderCmdBuffer_t *buf, int layer, renderPass_t pass,
+		float depth, int matrix, int texture)
+{
+	//Every recorder can get here at once, so only the first to swap it
+	//gets to complain
+	static int		warned = 0;
+	renderCmd_t		*cmd;
+
+	if(matrix == RC_MATRIX_FULL)
+		return NULL;
+
+	if(buf->numCmds >= MAX_RENDER_CMDS)
+	{
+		if(__sync_bool_compare_and_swap(&warned, 0, 1))
+			printf("Render commands: buffer overflow, dropping draws.\n");
+		return NULL;
+	}
+
+	cmd = &(buf->cmds[buf->numCmds]);
+
+	cmd->key	 = RC_KEY(layer, pass, renderer_cmd_quantizeDepth(layer, pass, depth), texture, buf->numCmds);
+	cmd->matrix	 = (matrix == RC_NO_MATRIX) ? NULL : buf->matrices[matrix];
+	cmd->matrixSlot = matrix;
+	cmd->texture = texture;
+	cmd->func	 = NULL;
+	cmd->arg	 = 0;
+	cmd->object	 = 0;
+
+	buf->numCmds++;
+	return cmd;
+}
+
+/*
+ * renderer_cmd_loadMatrix
+ * Copies a column-major modelview matrix into the buffer and returns a
+ * handle that later draws can reference. If there's no room, it's
+ * RC_MATRIX_FULL, and anything drawn with it is dropped rather than drawn
+ * with whatever matrix happens to be current.
+ */
+int renderer_cmd_loadMatrix(renderCmdBuffer_t *buf, const float *m)
+{
+	if(buf->numMatrices >= MAX_RENDER_MATRICES)
+	{
+		printf("Render commands: out of matrices.\n");
+		return RC_MATRIX_FULL;
+	}
+
+	memcpy(buf->matrices[buf->numMatrices], m, sizeof(float) * 16);
+	return buf->numMatrices++;
+}
+
+/*
+ * renderer_cmd_clear
+ */
+void renderer_cmd_clear(renderCmdBuffer_t *buf, int layer, int bits)
+{
+	renderCmd_t *cmd = renderer_cmd_alloc(buf, layer, RP_CLEAR, 0.0, RC_NO_MATRIX, 0);
+
+	if(cmd == NULL)
+		return;
+
+	cmd->type = RC_CLEAR;
+	cmd->arg  = bits;
+}
+
+/*
+ * renderer_cmd_drawModel
+ * depth is the view-space distance used for front to back sorting, see
+ * renderer_cmd_viewDepth. Translucent geom objects are drawn one by one,
+ * back to front. In RL_WORLD they're pulled out into RL_BLEND, in any
+ * other layer they're drawn in it, after everything opaque.
+ */
+void renderer_cmd_drawModel(renderCmdBuffer_t *buf, int layer, int matrix, int model,
+		float depth, int flags)
+{
+	renderCmd_t *cmd;
+	vec3_t		mins, maxs;
+	float		objectDepth;
+	int			i;
+
+	if(matrix == RC_MATRIX_FULL)
+		return;
+
+	for(i = 0; i < renderer_model_getNumObjects(model); i++)
+	{
+		if(!renderer_model_isObjectBlended(model, i))
+			continue;
+
+		objectDepth = depth;
+
+		if(matrix != RC_NO_MATRIX)
+		{
+			renderer_model_getObjectBounds(model, i, mins, maxs);
+			objectDepth = renderer_cmd_viewDepth(buf->matrices[matrix], mins, maxs);
+		}
+
+		if(layer == RL_WORLD)
+			cmd = renderer_cmd_alloc(buf, RL_BLEND, RP_COLOR, objectDepth, matrix, 0);
+		else
+			cmd = renderer_cmd_alloc(buf, layer, RP_BLEND, objectDepth, matrix, 0);
+
+		if(cmd == NULL)
+			return;
+
+		cmd->type	= RC_DRAW_OBJECT;
+		cmd->arg	= model;
+		cmd->object = i;
+	}
+
+	if(flags & RC_PREPASS)
+	{
+		cmd = renderer_cmd_alloc(buf, layer, RP_DEPTH, depth, matrix, 0);
+
+		if(cmd != NULL)
+		{
+			cmd->type = RC_DRAW_MODEL;
+			cmd->arg  = model;
+		}
+	}
+
+	cmd = renderer_cmd_alloc(buf, layer, RP_COLOR, depth, matrix, 0);
+
+	if(cmd == NULL)
+		return;
+
+	cmd->type = RC_DRAW_MODEL;
+	cmd->arg  = model;
+}
+
+/*
+ * renderer_cmd_drawFunc
+ * If texture is non-zero it is bound before func is called (and func is
+ * expected to leave it bound).
+ */
+void renderer_cmd_drawFunc(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		renderCmdDrawFunc_t func, int arg, float depth, int flags)
+{
+	renderCmd_t *cmd;
+
+	if(flags & RC_PREPASS)
+	{
+		cmd = renderer_cmd_alloc(buf, layer, RP_DEPTH, depth, matrix, texture);
+
+		if(cmd != NULL)
+		{
+			cmd->type = RC_DRAW_FUNC;
+			cmd->func = func;
+			cmd->arg  = arg;
+		}
+	}
+
+	cmd = renderer_cmd_alloc(buf, layer, RP_COLOR, depth, matrix, texture);
+
+	if(cmd == NULL)
+		return;
+
+	cmd->type = RC_DRAW_FUNC;
+	cmd->func = func;
+	cmd->arg  = arg;
+}
+
+/*
+ * renderer_cmd_allocVertices
+ * Space for numVerts vertices of dynamic geometry, drawn as one primitive
+ * batch. Every recorder's vertices are uploaded together in a single
+ * write to the stream buffer. Returns NULL if the buffer is out of room.
+ */
+streamVertex_t * renderer_cmd_allocVertices(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		GLenum mode, int numVerts, float depth)
+{
+	renderCmd_t *cmd;
+
+	if(buf->numVerts + numVerts > MAX_RENDER_VERTS)
+	{
+		printf("Render commands: out of vertices.\n");
+		return NULL;
+	}
+
+	cmd = renderer_cmd_alloc(buf, layer, RP_COLOR, depth, matrix, texture);
+
+	if(cmd == NULL)
+		return NULL;
+
+	cmd->type  = RC_DRAW_VERTS;
+	cmd->mode  = mode;
+	cmd->first = buf->numVerts;
+	cmd->count = numVerts;
+
+	buf->numVerts += numVerts;
+	return &(buf->verts[cmd->first]);
+}
+
+/*
+ * renderer_cmd_allocIndirect
+ * Space for count static mesh draw commands, all drawn with the given
+ * texture in one call. Like vertices, every recorder's commands go up to
+ * GL in a single upload. Returns NULL if the buffer is out of room.
+ */
+indirectCmd_t * renderer_cmd_allocIndirect(renderCmdBuffer_t *buf, int layer, int matrix, int texture,
+		int count, float depth)
+{
+	renderCmd_t *cmd;
+
+	if(buf->numIndirect + count > MAX_RENDER_INDIRECT)
+	{
+		printf("Render commands: out of indirect commands.\n");
+		return NULL;
+	}
+
+	cmd = renderer_cmd_alloc(buf, layer, RP_COLOR, depth, matrix, texture);
+
+	if(cmd == NULL)
+		return NULL;
+
+	cmd->type  = RC_DRAW_INDIRECT;
+	cmd->first = buf->numIndirect;
+	cmd->count = count;
+
+	buf->numIndirect += count;
+	return &(buf->indirect[cmd->first]);
+}
+
+/*
+ * renderer_cmd_viewDepth
+ * Distance in front of the camera of the center of a box, given the
+ * modelview it will be drawn with.
+ */
+float renderer_cmd_viewDepth(const float *modelview, const vec3_t mins, const vec3_t maxs)
+{
+	vec3_t center;
+
+	center[_X] = (mins[_X] + maxs[_X]) * 0.5;
+	center[_Y] = (mins[_Y] + maxs[_Y]) * 0.5;
+	center[_Z] = (mins[_Z] + maxs[_Z]) * 0.5;
+
+	return -(modelview[2] * center[_X] + modelview[6] * center[_Y] +
+			 modelview[10] * center[_Z] + modelview[14]);
+}
+
+/*
+===========================================================================
+Execution
+===========================================================================
+*/
+
+/*
+ * renderer_cmd_compare
+ * Ties (same key from different recorders) fall back on buffer order so
+ * the result never depends on qsort's whims.
+ */
+static int renderer_cmd_compare(const void *a, const void *b)
+{
+	const renderCmd_t *ca = *(const renderCmd_t **)a;
+	const renderCmd_t *cb = *(const renderCmd_t **)b;
+
+	if(ca->key != cb->key)
+		return (ca->key < cb->key) ? -1 : 1;
+
+	return (ca < cb) ? -1 : (ca > cb);
+}
+
+/*
+ * renderer_cmd_execute
+ * Merges every recorder's buffer, sorts, and issues the GL calls. Matrix
+ * loads and texture binds are only issued when they actually change.
+ */
+static void renderer_cmd_execute(renderFrame_t *frame)
+{
+	int				i, j, numSorted, curTexture, buffers;
+	int				layer, curLayer, pass, curPass;
+	int				numVerts, numIndirect, base;
+	int				features, curFeatures, curSlot, curMaterial;
+	eboolean		streamBound, sceneDone;
+	const float		*curMatrix;
+	float			*matrices;
+	renderCmd_t		*cmd;
+	streamVertex_t	*verts;
+
+	buffers		= numRecorders > 0 ? numRecorders : 1;
+	numSorted	= 0;
+	numVerts	= 0;
+	numIndirect	= 0;
+
+	for(i = 0; i < buffers; i++)
+	{
+		for(j = 0; j < frame->buffers[i].numCmds; j++)
+			sortedCmds[numSorted++] = &(frame->buffers[i].cmds[j]);
+
+		numVerts += frame->buffers[i].numVerts;
+	}
+
+	//All of the frame's dynamic geometry goes up in one write. Vertex
+	//commands get rebased to where their buffer landed.
+	if(numVerts > 0)
+	{
+		verts = renderer_stream_begin(numVerts);
+		base  = 0;
+
+		for(i = 0; i < buffers && verts != NULL; i++)
+		{
+			memcpy(verts + base, frame->buffers[i].verts, frame->buffers[i].numVerts * sizeof(streamVertex_t));
+
+			for(j = 0; j < frame->buffers[i].numCmds; j++)
+				if(frame->buffers[i].cmds[j].type == RC_DRAW_VERTS)
+					frame->buffers[i].cmds[j].first += base;
+
+			base += frame->buffers[i].numVerts;
+		}
+
+		if(verts != NULL)
+			renderer_stream_end(numVerts);
+		else
+			numVerts = 0;
+	}
+
+	//Static mesh commands too, into one shared array
+	for(i = 0; i < buffers; i++)
+	{
+		memcpy(indirectCmds + numIndirect, frame->buffers[i].indirect,
+				frame->buffers[i].numIndirect * sizeof(indirectCmd_t));
+
+		for(j = 0; j < frame->buffers[i].numCmds; j++)
+			if(frame->buffers[i].cmds[j].type == RC_DRAW_INDIRECT)
+				frame->buffers[i].cmds[j].first += numIndirect;
+
+		numIndirect += frame->buffers[i].numIndirect;
+	}
+
+	if(numIndirect > 0)
+		renderer_mesh_uploadIndirect(indirectCmds, numIndirect);
+
+	//And every matrix, so that each one is a range of one uniform buffer
+	if(shaders)
+	{
+		for(i = 0, base = 0; i < buffers; i++)
+			base += frame->buffers[i].numMatrices;
+
+		matrices = renderer_shader_beginMatrices(base);
+
+		for(i = 0, base = 0; i < buffers && matrices != NULL; i++)
+		{
+			memcpy(matrices + base * 16, frame->buffers[i].matrices, frame->buffers[i].numMatrices * sizeof(float) * 16);
+
+			for(j = 0; j < frame->buffers[i].numCmds; j++)
+				if(frame->buffers[i].cmds[j].matrixSlot != RC_NO_MATRIX)
+					frame->buffers[i].cmds[j].matrixSlot += base;
+
+			base += frame->buffers[i].numMatrices;
+		}
+
+		if(matrices != NULL)
+			renderer_shader_endMatrices(base);
+	}
+
+	streamBound = efalse;
+
+	qsort(sortedCmds, numSorted, sizeof(renderCmd_t *), renderer_cmd_compare);
+
+	curMatrix	= NULL;
+	curTexture	= -1;
+	curLayer	= -1;
+	curPass		= RP_CLEAR;
+	curFeatures	= -1;
+	curSlot		= RC_NO_MATRIX;
+	curMaterial	= SHADER_NO_MATERIAL - 1;
+
+	glMatrixMode(GL_MODELVIEW);
+
+	//Everything up to the overlay goes to the scene's render target
+	renderer_scale_beginScene();
+	sceneDone = efalse;
+
+	if(overdraw)
+		renderer_cmd_beginOverdraw();
+
+	for(i = 0; i < numSorted; i++)
+	{
+		cmd	  = sortedCmds[i];
+		layer = (int)(cmd->key >> 56);
+		pass  = (int)((cmd->key >> 52) & 0xF);
+
+		//Pass state never carries over into the next layer
+		if(layer != curLayer)
+		{
+			renderer_cmd_setPass(curPass, RP_CLEAR);
+			renderer_cmd_setLayer(curLayer, -1);
+
+			if(layer >= RL_OVERLAY && !sceneDone)
+			{
+				if(curFeatures >= 0)
+					renderer_shader_unbind();
+
+				renderer_cmd_endScene();
+
+				sceneDone	= etrue;
+				curFeatures	= -1;
+				curMatrix	= NULL;
+			}
+
+			renderer_cmd_setLayer(-1, layer);
+
+			curLayer   = layer;
+			curPass	   = RP_CLEAR;
+			curTexture = -1;
+		}
+
+		if(pass != curPass)
+		{
+			renderer_cmd_setPass(curPass, pass);
+			curPass = pass;
+		}
+
+		//Anything the shaders don't cover falls back on fixed function,
+		//which keeps its matrix in the matrix stack
+		features = shaders ? renderer_cmd_shaderFeatures(cmd, layer, pass, curFeatures) : -1;
+
+		if(features != curFeatures)
+		{
+			if(features < 0)
+				renderer_shader_unbind();
+			else
+				renderer_shader_bind(features);
+
+			curFeatures = features;
+		}
+
+		if(features >= 0)
+		{
+			if(cmd->matrixSlot != RC_NO_MATRIX && cmd->matrixSlot != curSlot)
+			{
+				renderer_shader_setMatrix(cmd->matrixSlot);
+				curSlot = cmd->matrixSlot;
+			}
+		}
+		else if(cmd->matrix != NULL && cmd->matrix != curMatrix)
+		{
+			glLoadMatrixf(cmd->matrix);
+			curMatrix = cmd->matrix;
+		}
+
+		if(streamBound && cmd->type != RC_DRAW_VERTS)
+		{
+			renderer_stream_unbind();
+			streamBound = efalse;
+		}
+
+		switch(cmd->type)
+		{
+		case RC_CLEAR:
+			glClear(cmd->arg);
+			break;
+		case RC_DRAW_MODEL:
+			//Display lists bind their own textures. With shaders, the
+			//model is drawn object by object so that each one gets its
+			//material.
+			if(features >= 0)
+			{
+				for(j = 0; j < renderer_model_getNumObjects(cmd->arg); j++)
+				{
+					if(renderer_model_isObjectBlended(cmd->arg, j))
+						continue;
+
+					renderer_cmd_setMaterial(renderer_model_getObjectMaterial(cmd->arg, j), &curMaterial);
+					renderer_model_drawObject(cmd->arg, j);
+				}
+			}
+			else
+				renderer_model_drawASE(cmd->arg);
+
+			curTexture = -1;
+			break;
+		case RC_DRAW_OBJECT:
+			if(features >= 0)
+				renderer_cmd_setMaterial(renderer_model_getObjectMaterial(cmd->arg, cmd->object), &curMaterial);
+
+			renderer_model_drawObject(cmd->arg, cmd->object);
+			curTexture = -1;
+			break;
+		case RC_DRAW_FUNC:
+			if(cmd->texture != 0 && cmd->texture != curTexture)
+			{
+				glBindTexture(GL_TEXTURE_2D, cmd->texture);
+				curTexture = cmd->texture;
+			}
+
+			cmd->func(cmd->arg);
+
+			if(cmd->texture == 0)
+				curTexture = -1;
+			break;
+		case RC_DRAW_VERTS:
+			//Dropped if the stream couldn't take this frame's vertices
+			if(numVerts == 0)
+				break;
+
+			if(!streamBound)
+			{
+				renderer_stream_bind();
+				streamBound = etrue;
+			}
+
+			if(features >= 0)
+				renderer_cmd_setMaterial(SHADER_NO_MATERIAL, &curMaterial);
+
+			if(cmd->texture == 0)
+			{
+				glDisable(GL_TEXTURE_2D);
+				glDrawArrays(cmd->mode, cmd->first, cmd->count);
+				glEnable(GL_TEXTURE_2D);
+			}
+			else
+			{
+				if(cmd->texture != curTexture)
+				{
+					glBindTexture(GL_TEXTURE_2D, cmd->texture);
+					curTexture = cmd->texture;
+				}
+
+				glDrawArrays(cmd->mode, cmd->first, cmd->count);
+			}
+			break;
+		case RC_DRAW_INDIRECT:
+			if(cmd->texture != curTexture)
+			{
+				glBindTexture(GL_TEXTURE_2D, cmd->texture);
+				curTexture = cmd->texture;
+			}
+
+			if(features >= 0)
+				renderer_cmd_setMaterial(SHADER_NO_MATERIAL, &curMaterial);
+
+			renderer_mesh_drawIndirect(cmd->first, cmd->count);
+			break;
+		}
+	}
+
+	if(curFeatures >= 0)
+		renderer_shader_unbind();
+
+	if(streamBound)
+		renderer_stream_unbind();
+
+	renderer_cmd_setPass(curPass, RP_CLEAR);
+	renderer_cmd_setLayer(curLayer, -1);
+
+	if(!sceneDone)
+		renderer_cmd_endScene();
+
+	if(numVerts > 0)
+		renderer_stream_endFrame();
+}
+
+/*
+ * renderer_cmd_shaderFeatures
+ * Which uber-shader a command is drawn with, or -1 for fixed function.
+ * Clears don't care, so they stay with whatever is current.
+ */
+static int renderer_cmd_shaderFeatures(const renderCmd_t *cmd, int layer, int pass, int current)
+{
+	int features;
+
+	switch(cmd->type)
+	{
+	case RC_CLEAR:
+		return current;
+	case RC_DRAW_MODEL:
+	case RC_DRAW_OBJECT:
+		features = SHADER_TEXTURED;
+
+		if(layer == RL_BLEND || pass == RP_BLEND)
+			features |= SHADER_ALPHA;
+		if(shadersLit)
+			features |= SHADER_LIT;
+
+		return features;
+	case RC_DRAW_VERTS:
+		return cmd->texture ? SHADER_VERTEX_COLOR | SHADER_TEXTURED : SHADER_VERTEX_COLOR;
+	case RC_DRAW_INDIRECT:
+		return SHADER_TEXTURED;
+	default:
+		//Callbacks are free to do whatever they like with GL
+		return -1;
+	}
+}
+
+/*
+ * renderer_cmd_setMaterial
+ */
+static void renderer_cmd_setMaterial(int material, int *current)
+{
+	if(material == *current)
+		return;
+
+	renderer_shader_setMaterial(material);
+	*current = material;
+}
+
+/*
+ * renderer_cmd_beginBlend
+ * Opacity comes in through the current color, so the texture environment
+ * has to modulate. Undone with glPopAttrib.
+ */
+static void renderer_cmd_beginBlend()
+{
+	glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glDepthMask(GL_FALSE);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+}
+
+/*
+ * renderer_cmd_setLayer
+ * Blend state is set once for the whole translucent layer rather than per
+ * object.
+ */
+static void renderer_cmd_setLayer(int from, int to)
+{
+	if(from == RL_BLEND || from == RL_OVERLAY)
+		glPopAttrib();
+
+	if(to == RL_BLEND)
+		renderer_cmd_beginBlend();
+	else if(to == RL_OVERLAY)
+	{
+		//The scene's depth may be in another render target by now
+		glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_DEPTH_TEST);
+	}
+}
+
+/*
+ * renderer_cmd_endScene
+ * Overdraw has to be counted before the scene leaves its render target.
+ */
+static void renderer_cmd_endScene()
+{
+	if(overdraw)
+		renderer_cmd_endOverdraw();
+
+	renderer_scale_endScene();
+}
+
+/*
+ * renderer_cmd_setPass
+ * The depth pass only writes depth. The color pass after it has to accept
+ * fragments at exactly the depth that was laid down. The blend pass is
+ * set up the same as RL_BLEND.
+ */
+static void renderer_cmd_setPass(int from, int to)
+{
+	if(from == RP_BLEND)
+		glPopAttrib();
+
+	if(to == RP_BLEND)
+		renderer_cmd_beginBlend();
+
+	if(to == RP_DEPTH)
+	{
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+		//Only count fragments that actually get shaded
+		if(overdraw)
+			glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	}
+	else if(from == RP_DEPTH)
+	{
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		if(overdraw)
+			glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	}
+
+	if(to == RP_COLOR && from == RP_DEPTH)
+		glDepthFunc(GL_LEQUAL);
+	else if(to == RP_CLEAR)
+		glDepthFunc(GL_LESS);
+}
+
+/*
+ * renderer_cmd_setShaders
+ */
+void renderer_cmd_setShaders(eboolean enable, eboolean lit)
+{
+	shaders	   = enable;
+	shadersLit = lit;
+}
+
+/*
+===========================================================================
+Overdraw
+===========================================================================
+*/
+
+/*
+ * renderer_cmd_setOverdraw
+ * While on, every fragment that passes the depth test bumps the stencil
+ * buffer, and the total is read back after each frame. Slow.
+ */
+void renderer_cmd_setOverdraw(eboolean enable)
+{
+	overdraw	  = enable;
+	overdrawRatio = 0.0;
+}
+
+/*
+ * renderer_cmd_getOverdraw
+ * Shaded fragments per pixel in the last executed frame.
+ */
+float renderer_cmd_getOverdraw()
+{
+	return overdrawRatio;
+}
+
+/*
+ * renderer_cmd_beginOverdraw
+ */
+static void renderer_cmd_beginOverdraw()
+{
+	glClearStencil(0);
+	glClear(GL_STENCIL_BUFFER_BIT);
+
+	glEnable(GL_STENCIL_TEST);
+	glStencilFunc(GL_ALWAYS, 0, 0xFF);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+}
+
+/*
+ * renderer_cmd_endOverdraw
+ * Leaves the last ratio alone if the counts can't be read back.
+ */
+static void renderer_cmd_endOverdraw()
+{
+	GLint		viewport[4];
+	byte		*counts;
+	double		total;
+	int			i, pixels;
+
+	glDisable(GL_STENCIL_TEST);
+	glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	pixels = viewport[2] * viewport[3];
+
+	if(pixels <= 0)
+		return;
+
+	counts = (byte *)malloc(pixels);
+
+	if(counts == NULL)
+		return;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(viewport[0], viewport[1], viewport[2], viewport[3],
+			GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, counts);
+
+	for(i = 0, total = 0.0; i < pixels; i++)
+		total += counts[i];
+
+	free(counts);
+
+	overdrawRatio = total / pixels;
+}
@@ -0,0 +1,265 @@
+/*
+===========================================================================
+File:		renderer_glext.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#include "headers/SDL/SDL.h"
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+
+#include "headers/renderer_glext.h"
+
+glConfig_t glConfig;
+
+PFNGLGENBUFFERSPROC		qglGenBuffers;
+PFNGLDELETEBUFFERSPROC	qglDeleteBuffers;
+PFNGLBINDBUFFERPROC		qglBindBuffer;
+PFNGLBUFFERDATAPROC		qglBufferData;
+PFNGLBUFFERSUBDATAPROC	qglBufferSubData;
+
+qglMapBufferRange_t		qglMapBufferRange;
+qglBufferStorage_t		qglBufferStorage;
+qglFenceSync_t			qglFenceSync;
+qglClientWaitSync_t		qglClientWaitSync;
+qglDeleteSync_t			qglDeleteSync;
+
+PFNGLGENFRAMEBUFFERSEXTPROC			qglGenFramebuffers;
+PFNGLDELETEFRAMEBUFFERSEXTPROC		qglDeleteFramebuffers;
+PFNGLBINDFRAMEBUFFEREXTPROC			qglBindFramebuffer;
+PFNGLFRAMEBUFFERTEXTURE2DEXTPROC	qglFramebufferTexture2D;
+PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC	qglCheckFramebufferStatus;
+PFNGLGENRENDERBUFFERSEXTPROC		qglGenRenderbuffers;
+PFNGLDELETERENDERBUFFERSEXTPROC		qglDeleteRenderbuffers;
+PFNGLBINDRENDERBUFFEREXTPROC		qglBindRenderbuffer;
+PFNGLRENDERBUFFERSTORAGEEXTPROC		qglRenderbufferStorage;
+PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC	qglFramebufferRenderbuffer;
+
+PFNGLCREATESHADERPROC		qglCreateShader;
+PFNGLDELETESHADERPROC		qglDeleteShader;
+PFNGLSHADERSOURCEPROC		qglShaderSource;
+PFNGLCOMPILESHADERPROC		qglCompileShader;
+PFNGLGETSHADERIVPROC		qglGetShaderiv;
+PFNGLGETSHADERINFOLOGPROC	qglGetShaderInfoLog;
+PFNGLCREATEPROGRAMPROC		qglCreateProgram;
+PFNGLDELETEPROGRAMPROC		qglDeleteProgram;
+PFNGLATTACHSHADERPROC		qglAttachShader;
+PFNGLLINKPROGRAMPROC		qglLinkProgram;
+PFNGLGETPROGRAMIVPROC		qglGetProgramiv;
+PFNGLGETPROGRAMINFOLOGPROC	qglGetProgramInfoLog;
+PFNGLUSEPROGRAMPROC			qglUseProgram;
+qglGetUniformBlockIndex_t	qglGetUniformBlockIndex;
+qglUniformBlockBinding_t	qglUniformBlockBinding;
+qglBindBufferRange_t		qglBindBufferRange;
+
+qglMultiDrawElementsIndirect_t	qglMultiDrawElementsIndirect;
+
+PFNGLCOMPRESSEDTEXIMAGE2DPROC	qglCompressedTexImage2D;
+
+static glGetProc_t glGetProc;
+
+/*
+ * renderer_glext_hasExtension
+ * Matches whole names only, so GL_ARB_foo doesn't match GL_ARB_foo_bar.
+ */
+eboolean renderer_glext_hasExtension(const char *name)
+{
+	const char	*extensions, *start;
+	int			length;
+
+	extensions = (const char *)glGetString(GL_EXTENSIONS);
+	length	   = strlen(name);
+
+	if(extensions == NULL)
+		return efalse;
+
+	for(start = extensions; (start = strstr(start, name)) != NULL; start += length)
+	{
+		if((start == extensions || start[-1] == ' ') &&
+		   (start[length] == ' ' || start[length] == '\0'))
+			return etrue;
+	}
+
+	return efalse;
+}
+
+/*
+ * renderer_glext_version
+ * True if the context is at least the given version.
+ */
+static eboolean renderer_glext_version(int major, int minor)
+{
+	return glConfig.versionMajor > major ||
+			(glConfig.versionMajor == major && glConfig.versionMinor >= minor);
+}
+
+/*
+ * renderer_glext_getProc
+ * Returns NULL if the name couldn't be resolved, so callers can turn the
+ * feature off.
+ */
+static void * renderer_glext_getProc(const char *name)
+{
+	return glGetProc(name);
+}
+
+/*
+ * renderer_glext_getFramebufferProcs
+ * suffix is "" for the core/ARB names or "EXT".
+ */
+static void renderer_glext_getFramebufferProcs(const char *suffix)
+{
+	char name[64];
+
+#define GET_FBO_PROC(var, type, base) \
+	sprintf(name, "%s%s", base, suffix); \
+	var = (type)renderer_glext_getProc(name)
+
+	GET_FBO_PROC(qglGenFramebuffers,		 PFNGLGENFRAMEBUFFERSEXTPROC,		  "glGenFramebuffers");
+	GET_FBO_PROC(qglDeleteFramebuffers,		 PFNGLDELETEFRAMEBUFFERSEXTPROC,	  "glDeleteFramebuffers");
+	GET_FBO_PROC(qglBindFramebuffer,		 PFNGLBINDFRAMEBUFFEREXTPROC,		  "glBindFramebuffer");
+	GET_FBO_PROC(qglFramebufferTexture2D,	 PFNGLFRAMEBUFFERTEXTURE2DEXTPROC,	  "glFramebufferTexture2D");
+	GET_FBO_PROC(qglCheckFramebufferStatus,	 PFNGLCHECKFRAMEBUFFERSTATUSEXTPROC,  "glCheckFramebufferStatus");
+	GET_FBO_PROC(qglGenRenderbuffers,		 PFNGLGENRENDERBUFFERSEXTPROC,		  "glGenRenderbuffers");
+	GET_FBO_PROC(qglDeleteRenderbuffers,	 PFNGLDELETERENDERBUFFERSEXTPROC,	  "glDeleteRenderbuffers");
+	GET_FBO_PROC(qglBindRenderbuffer,		 PFNGLBINDRENDERBUFFEREXTPROC,		  "glBindRenderbuffer");
+	GET_FBO_PROC(qglRenderbufferStorage,	 PFNGLRENDERBUFFERSTORAGEEXTPROC,	  "glRenderbufferStorage");
+	GET_FBO_PROC(qglFramebufferRenderbuffer, PFNGLFRAMEBUFFERRENDERBUFFEREXTPROC, "glFramebufferRenderbuffer");
+
+#undef GET_FBO_PROC
+}
+
+/*
+ * renderer_glext_init
+ * Must be called once the GL context exists.
+ */
+void renderer_glext_init(glGetProc_t getProc)
+{
+	const char *version;
+
+	glGetProc = getProc ? getProc : SDL_GL_GetProcAddress;
+
+	memset(&glConfig, 0, sizeof(glConfig));
+
+	version = (const char *)glGetString(GL_VERSION);
+	if(version != NULL)
+		sscanf(version, "%d.%d", &glConfig.versionMajor, &glConfig.versionMinor);
+
+	//Buffer objects
+	if(renderer_glext_version(1, 5))
+	{
+		qglGenBuffers		= (PFNGLGENBUFFERSPROC)renderer_glext_getProc("glGenBuffers");
+		qglDeleteBuffers	= (PFNGLDELETEBUFFERSPROC)renderer_glext_getProc("glDeleteBuffers");
+		qglBindBuffer		= (PFNGLBINDBUFFERPROC)renderer_glext_getProc("glBindBuffer");
+		qglBufferData		= (PFNGLBUFFERDATAPROC)renderer_glext_getProc("glBufferData");
+		qglBufferSubData	= (PFNGLBUFFERSUBDATAPROC)renderer_glext_getProc("glBufferSubData");
+	}
+	else if(renderer_glext_hasExtension("GL_ARB_vertex_buffer_object"))
+	{
+		qglGenBuffers		= (PFNGLGENBUFFERSPROC)renderer_glext_getProc("glGenBuffersARB");
+		qglDeleteBuffers	= (PFNGLDELETEBUFFERSPROC)renderer_glext_getProc("glDeleteBuffersARB");
+		qglBindBuffer		= (PFNGLBINDBUFFERPROC)renderer_glext_getProc("glBindBufferARB");
+		qglBufferData		= (PFNGLBUFFERDATAPROC)renderer_glext_getProc("glBufferDataARB");
+		qglBufferSubData	= (PFNGLBUFFERSUBDATAPROC)renderer_glext_getProc("glBufferSubDataARB");
+	}
+
+	glConfig.vertexBufferObject = qglGenBuffers && qglDeleteBuffers && qglBindBuffer &&
+			qglBufferData && qglBufferSubData;
+
+	//Persistently mapped buffers. The core names and the ARB names are the
+	//same for all three of these.
+	if(glConfig.vertexBufferObject &&
+	   (renderer_glext_version(4, 4) || renderer_glext_hasExtension("GL_ARB_buffer_storage")) &&
+	   (renderer_glext_version(3, 0) || renderer_glext_hasExtension("GL_ARB_map_buffer_range")) &&
+	   (renderer_glext_version(3, 2) || renderer_glext_hasExtension("GL_ARB_sync")))
+	{
+		qglBufferStorage	= (qglBufferStorage_t)renderer_glext_getProc("glBufferStorage");
+		qglMapBufferRange	= (qglMapBufferRange_t)renderer_glext_getProc("glMapBufferRange");
+		qglFenceSync		= (qglFenceSync_t)renderer_glext_getProc("glFenceSync");
+		qglClientWaitSync	= (qglClientWaitSync_t)renderer_glext_getProc("glClientWaitSync");
+		qglDeleteSync		= (qglDeleteSync_t)renderer_glext_getProc("glDeleteSync");
+
+		glConfig.persistentMapping = qglBufferStorage && qglMapBufferRange &&
+				qglFenceSync && qglClientWaitSync && qglDeleteSync;
+	}
+
+	//Multi-draw indirect. The extension is written against 4.0, where
+	//the indirect buffer binding comes from.
+	if(glConfig.vertexBufferObject &&
+	   (renderer_glext_version(4, 3) ||
+	   (renderer_glext_hasExtension("GL_ARB_multi_draw_indirect") &&
+	   (renderer_glext_version(4, 0) || renderer_glext_hasExtension("GL_ARB_draw_indirect")))))
+	{
+		qglMultiDrawElementsIndirect = (qglMultiDrawElementsIndirect_t)renderer_glext_getProc("glMultiDrawElementsIndirect");
+
+		glConfig.multiDrawIndirect = qglMultiDrawElementsIndirect != NULL;
+	}
+
+	//Framebuffer objects. The EXT version only gets a packed depth/stencil
+	//format with EXT_packed_depth_stencil.
+	if(renderer_glext_version(3, 0) || renderer_glext_hasExtension("GL_ARB_framebuffer_object"))
+		renderer_glext_getFramebufferProcs("");
+	else if(renderer_glext_hasExtension("GL_EXT_framebuffer_object") &&
+			renderer_glext_hasExtension("GL_EXT_packed_depth_stencil"))
+		renderer_glext_getFramebufferProcs("EXT");
+
+	glConfig.framebufferObject = qglGenFramebuffers && qglDeleteFramebuffers && qglBindFramebuffer &&
+			qglFramebufferTexture2D && qglCheckFramebufferStatus && qglGenRenderbuffers &&
+			qglDeleteRenderbuffers && qglBindRenderbuffer && qglRenderbufferStorage &&
+			qglFramebufferRenderbuffer;
+
+	glConfig.bgra = renderer_glext_version(1, 2) || renderer_glext_hasExtension("GL_EXT_bgra");
+
+	glConfig.pixelBufferObject = glConfig.vertexBufferObject &&
+			(renderer_glext_version(2, 1) || renderer_glext_hasExtension("GL_ARB_pixel_buffer_object"));
+
+	//S3TC is only ever an extension, on top of the generic compressed
+	//texture entry points
+	if(renderer_glext_hasExtension("GL_EXT_texture_compression_s3tc"))
+	{
+		if(renderer_glext_version(1, 3))
+			qglCompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC)renderer_glext_getProc("glCompressedTexImage2D");
+		else if(renderer_glext_hasExtension("GL_ARB_texture_compression"))
+			qglCompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC)renderer_glext_getProc("glCompressedTexImage2DARB");
+
+		glConfig.textureCompressionS3TC = qglCompressedTexImage2D != NULL;
+	}
+
+	//Shaders. Uniform blocks need GLSL 1.40, so this waits for 3.1 rather
+	//than piecing it together out of extensions.
+	if(glConfig.vertexBufferObject && renderer_glext_version(3, 1))
+	{
+		qglCreateShader			= (PFNGLCREATESHADERPROC)renderer_glext_getProc("glCreateShader");
+		qglDeleteShader			= (PFNGLDELETESHADERPROC)renderer_glext_getProc("glDeleteShader");
+		qglShaderSource			= (PFNGLSHADERSOURCEPROC)renderer_glext_getProc("glShaderSource");
+		qglCompileShader		= (PFNGLCOMPILESHADERPROC)renderer_glext_getProc("glCompileShader");
+		qglGetShaderiv			= (PFNGLGETSHADERIVPROC)renderer_glext_getProc("glGetShaderiv");
+		qglGetShaderInfoLog		= (PFNGLGETSHADERINFOLOGPROC)renderer_glext_getProc("glGetShaderInfoLog");
+		qglCreateProgram		= (PFNGLCREATEPROGRAMPROC)renderer_glext_getProc("glCreateProgram");
+		qglDeleteProgram		= (PFNGLDELETEPROGRAMPROC)renderer_glext_getProc("glDeleteProgram");
+		qglAttachShader			= (PFNGLATTACHSHADERPROC)renderer_glext_getProc("glAttachShader");
+		qglLinkProgram			= (PFNGLLINKPROGRAMPROC)renderer_glext_getProc("glLinkProgram");
+		qglGetProgramiv			= (PFNGLGETPROGRAMIVPROC)renderer_glext_getProc("glGetProgramiv");
+		qglGetProgramInfoLog	= (PFNGLGETPROGRAMINFOLOGPROC)renderer_glext_getProc("glGetProgramInfoLog");
+		qglUseProgram			= (PFNGLUSEPROGRAMPROC)renderer_glext_getProc("glUseProgram");
+		qglGetUniformBlockIndex	= (qglGetUniformBlockIndex_t)renderer_glext_getProc("glGetUniformBlockIndex");
+		qglUniformBlockBinding	= (qglUniformBlockBinding_t)renderer_glext_getProc("glUniformBlockBinding");
+		qglBindBufferRange		= (qglBindBufferRange_t)renderer_glext_getProc("glBindBufferRange");
+
+		glConfig.shaders = qglCreateShader && qglDeleteShader && qglShaderSource && qglCompileShader &&
+				qglGetShaderiv && qglGetShaderInfoLog && qglCreateProgram && qglDeleteProgram &&
+				qglAttachShader && qglLinkProgram && qglGetProgramiv && qglGetProgramInfoLog &&
+				qglUseProgram && qglGetUniformBlockIndex && qglUniformBlockBinding && qglBindBufferRange;
+	}
+
+	printf("GL %d.%d, vertex buffers: %s, persistent mapping: %s, multi-draw indirect: %s, shaders: %s, "
+			"framebuffer objects: %s, BGRA: %s, S3TC: %s, PBOs: %s\n", glConfig.versionMajor, glConfig.versionMinor,
+			glConfig.vertexBufferObject ? "yes" : "no", glConfig.persistentMapping ? "yes" : "no",
+			glConfig.multiDrawIndirect ? "yes" : "no", glConfig.shaders ? "yes" : "no",
+			glConfig.framebufferObject ? "yes" : "no", glConfig.bgra ? "yes" : "no",
+			glConfig.textureCompressionS3TC ? "yes" : "no", glConfig.pixelBufferObject ? "yes" : "no");
+}
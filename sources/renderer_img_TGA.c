@@ -12,10 +12,33 @@ Created on: Sep 29, 2010
 #include "headers/files.h"
 #include "headers/mathlib.h"
 
+#include "headers/renderer_glext.h"
 #include "headers/renderer_materials.h"
 
 #define HEADER_SIZE 18
 
+//Image types
+#define TGA_COLORMAP		1
+#define TGA_TRUECOLOR		2
+#define TGA_COLORMAP_RLE	9
+#define TGA_TRUECOLOR_RLE	10
+
+//Top bit of an RLE packet header says it's a run, the rest is the count - 1
+#define TGA_RLE_RUN			0x80
+
+//Attribute bit for an image stored top row first
+#define TGA_ORIGIN_TOP		0x20
+
+//Attribute bits for how many bits of each pixel are alpha
+#define TGA_ALPHA_BITS		0x0f
+
+//Alpha bit of a 16 bit pixel (5551), the rest is 5 bits each of BGR
+#define TGA_ALPHA_5551		0x8000
+
+//Widest or tallest image we'll read, the biggest texture most GL drivers
+//take. Keeps the size of a whole 32 bit image well inside an int.
+#define TGA_MAX_SIZE		16384
+
 typedef struct
 {
 	unsigned char 	idLength, colormapType, imageType;
@@ -26,48 +49,256 @@ typedef struct
 }
 tgaHeader_t;
 
+//Loads that went up to GL straight out of the file buffer, and ones that
+//needed a pass over the pixels first. Bottom up files are turned over on
+//the way up, so they count as converted. The loader threads read files
+//too, so these are only ever added to atomically.
+static int zeroCopyLoads = 0, convertedLoads = 0;
+
+static eboolean packed16 = efalse;
+
 /*
- * Function: renderer_img_loadTGA
- * Description: Loads a TARGA image file, uploads to GL, and returns the
- * texture ID. Only supports 24/32 bit.
- * TODO: Eventually want to look into keeping only a single reference to any
- * given texture file (q3 uses a hashtable?)
- * TODO: Move file checking code elsewhere
+ * Function: renderer_img_tgaBpp
+ * Description: The bits per pixel an image decodes to, from its raw
+ * header: 24 or 32, or 0 if it isn't one we can read. 16 bit colors only
+ * have alpha if the header says they do.
  */
-void renderer_img_loadTGA(char *name, int *glTexID, int *width, int *height, int *bpp)
+static int renderer_img_tgaBpp(const byte *header)
 {
-	int				dataSize, rows, cols, i, j;
-	GLuint			type;
-	byte			*buf, *imageData, *pixelBuf, red, green, blue, alpha;
+	int depth;
 
-	FILE 			*file;
-	tgaHeader_t		header;
-	struct stat 	st;
+	switch(header[2])
+	{
+		case TGA_COLORMAP:
+		case TGA_COLORMAP_RLE:
+			if(header[1] != 1 || (header[16] != 8 && header[16] != 16))
+				return 0;
+
+			depth = header[7];
+			break;
+
+		case TGA_TRUECOLOR:
+		case TGA_TRUECOLOR_RLE:
+			depth = header[16];
+			break;
+
+		default:
+			return 0;
+	}
+
+	if(depth == 15 || depth == 16)
+		return (depth == 16 && (header[17] & TGA_ALPHA_BITS)) ? 32 : 24;
 
-	file = fopen(name, "rb");
+	return (depth == 24 || depth == 32) ? depth : 0;
+}
+
+/*
+ * Function: renderer_img_tgaSize
+ * Description: Bytes in width x height pixels of comps bytes each, or 0 if
+ * either side is 0 or bigger than TGA_MAX_SIZE.
+ */
+static int renderer_img_tgaSize(int width, int height, int comps)
+{
+	if(width <= 0 || height <= 0 || width > TGA_MAX_SIZE || height > TGA_MAX_SIZE)
+		return 0;
+
+	return (int)((size_t)width * height * comps);
+}
+
+/*
+ * Function: renderer_img_expand16
+ * Description: One 5551 color, as BGR(A).
+ */
+static void renderer_img_expand16(const byte *in, byte *out, int comps)
+{
+	int color, c;
+
+	color = in[0] | (in[1] << 8);
+
+	if(comps == 4)
+		out[3] = (color & TGA_ALPHA_5551) ? 255 : 0;
+
+	for(c = 0; c < 3; c++, color >>= 5)
+		out[c] = ((color & 0x1f) << 3) | ((color & 0x1f) >> 2);
+}
 
-	if(file == NULL)
+/*
+ * Function: renderer_img_expandPixels
+ * Description: Color mapped or 16 bit pixels, still in file order, to
+ * BGR(A) with comps bytes each. oneBitAlpha is set if every alpha is 0 or
+ * 255. Returns efalse, having said why, if a color map index is out of
+ * range or there's no memory for the color map.
+ */
+static eboolean renderer_img_expandPixels(const char *name, const tgaHeader_t *header, const byte *colormap,
+		const byte *in, byte *out, int comps, eboolean *oneBitAlpha)
+{
+	int		numPixels, entrySize, i, index;
+	byte	*palette;
+
+	numPixels	 = header->width * header->height;
+	*oneBitAlpha = etrue;
+
+	if(header->imageType == TGA_TRUECOLOR || header->imageType == TGA_TRUECOLOR_RLE)
 	{
-		printf("Loading TGA: %s, failed. Null file pointer.\n", name);
-		return;
+		for(i = 0; i < numPixels; i++, in += 2, out += comps)
+			renderer_img_expand16(in, out, comps);
+
+		return etrue;
 	}
 
-	if(stat(name, &st))
+	//The color map goes to BGR(A) first, then it's just a lookup a pixel
+	entrySize = (header->colormapSize + 7) / 8;
+	palette	  = (byte *)malloc(header->colormapLength * comps);
+
+	if(palette == NULL)
 	{
-		printf("Loading TGA: %s, failed. Could not determine file size.\n", name);
-		return;
+		printf("Loading TGA: %s, failed. Out of memory.\n", name);
+		return efalse;
 	}
 
-	if(st.st_size < HEADER_SIZE)
+	for(i = 0; i < header->colormapLength; i++, colormap += entrySize)
 	{
-		printf("Loading TGA: %s, failed. Header too short.\n", name);
-		return;
+		if(entrySize == 2)
+			renderer_img_expand16(colormap, palette + i * comps, comps);
+		else
+			memcpy(palette + i * comps, colormap, comps);
+
+		if(comps == 4 && palette[i * 4 + 3] != 0 && palette[i * 4 + 3] != 255)
+			*oneBitAlpha = efalse;
+	}
+
+	for(i = 0; i < numPixels; i++, out += comps)
+	{
+		if(header->pixelSize == 16)
+		{
+			index = in[0] | (in[1] << 8);
+			in += 2;
+		}
+		else
+			index = *in++;
+
+		index -= header->colormapIndex;
+
+		if(index < 0 || index >= header->colormapLength)
+		{
+			printf("Loading TGA: %s, failed. Color map index out of range.\n", name);
+			free(palette);
+			return efalse;
+		}
+
+		memcpy(out, palette + index * comps, comps);
+	}
+
+	free(palette);
+	return etrue;
+}
+
+/*
+ * Function: renderer_img_setPacked16
+ * Description: With this on, images that were color mapped or 16 bit in
+ * the file, and have no more than on/off alpha, are uploaded as 16 bit
+ * textures (RGB5, RGB5_A1). Images read after it's set get it.
+ */
+void renderer_img_setPacked16(eboolean enable)
+{
+	packed16 = enable;
+}
+
+/*
+ * Function: renderer_img_expandRLE
+ * Description: Expands RLE packets from in into exactly outSize bytes of
+ * pixels, still in file order. A run writes its pixel once and then keeps
+ * copying everything it has written so far onto the end of itself, so a
+ * run of n pixels takes log2(n) memcpys. Returns efalse if the packets
+ * run past the end of either buffer.
+ */
+static eboolean renderer_img_expandRLE(const byte *in, int inSize, byte *out, int outSize, int pixelSize)
+{
+	const byte	*inEnd = in + inSize;
+	byte		*outEnd = out + outSize;
+	int			count, size, filled, chunk;
+
+	while(out < outEnd)
+	{
+		if(in >= inEnd)
+			return efalse;
+
+		count = (*in & ~TGA_RLE_RUN) + 1;
+		size  = count * pixelSize;
+
+		if(size > outEnd - out)
+			return efalse;
+
+		if(*in++ & TGA_RLE_RUN)
+		{
+			if(pixelSize > inEnd - in)
+				return efalse;
+
+			memcpy(out, in, pixelSize);
+			in += pixelSize;
+
+			for(filled = pixelSize; filled < size; filled += chunk)
+			{
+				chunk = (filled < size - filled) ? filled : size - filled;
+				memcpy(out + filled, out, chunk);
+			}
+		}
+		else
+		{
+			if(size > inEnd - in)
+				return efalse;
+
+			memcpy(out, in, size);
+			in += size;
+		}
+
+		out += size;
 	}
 
-	buf = (byte *)malloc(st.st_size);
-	fread(buf, sizeof(byte), st.st_size, file);
+	return etrue;
+}
+
+/*
+ * Function: renderer_img_readTGA
+ * Description: Reads a TARGA image file into memory. Supports 24/32 bit,
+ * 15/16 bit and 8 bit color mapped, uncompressed or RLE. The last two are
+ * expanded to 24/32 bit. With native set the pixels stay BGR(A) in the
+ * file's row order, and an uncompressed 24/32 bit image isn't copied at
+ * all, data just points into the file buffer. Otherwise they're RGB(A), top row
+ * first. The caller frees the pixels with renderer_img_freeImage. Safe to
+ * call from any thread.
+ * TODO: Move file checking code elsewhere
+ */
+eboolean renderer_img_readTGA(char *name, image_t *image, eboolean native)
+{
+	int				dataSize, skip, fileSize, bpp, pixelSize, packFlags;
+	const byte		*buf, *colormap;
+	byte			*fileBuf, *pixelBuf, *imageData;
+	eboolean		colormapped, oneBitAlpha;
+
+	tgaHeader_t		header;
+
+	image->data		 = NULL;
+	image->block	 = NULL;
+	image->flags	 = 0;
+	image->numLevels = 0;
 
-	fclose(file);
+	//Straight out of the pack if it's in there, otherwise fileBuf is the
+	//file read into memory
+	buf = files_loadAsset(name, &fileSize, &fileBuf);
+
+	if(buf == NULL)
+	{
+		printf("Loading TGA: %s, failed. Null file pointer.\n", name);
+		return efalse;
+	}
+
+	if(fileSize < HEADER_SIZE)
+	{
+		printf("Loading TGA: %s, failed. Header too short.\n", name);
+		free(fileBuf);
+		return efalse;
+	}
 
 	memcpy(&header.idLength, 	 	&buf[0],  1);
 	memcpy(&header.colormapType, 	&buf[1],  1);
@@ -82,83 +313,174 @@ void renderer_img_loadTGA(char *name, int *glTexID, int *width, int *height, int
 	memcpy(&header.pixelSize,		&buf[16], 1);
 	memcpy(&header.attributes,		&buf[17], 1);
 
-	//Advance past the header
-	buf += HEADER_SIZE;
+	if(header.imageType != TGA_TRUECOLOR && header.imageType != TGA_TRUECOLOR_RLE &&
+	   header.imageType != TGA_COLORMAP && header.imageType != TGA_COLORMAP_RLE)
+	{
+		printf("Loading TGA: %s, failed. Image type %d isn't supported.\n", name, header.imageType);
+		free(fileBuf);
+		return efalse;
+	}
+
+	bpp = renderer_img_tgaBpp(buf);
 
-	//I don't care too much about < 24 bits right now, but shouldn't be too hard...
-	//TODO: support < 24 bit tga's
-	if(header.pixelSize != 24 && header.pixelSize != 32)
+	if(!bpp)
 	{
-		printf("Loading TGA: %s, failed. Only support 24/32 bit images.\n", name);
-		return;
+		printf("Loading TGA: %s, failed. Only support 15/16/24/32 bit and 8 bit color mapped images.\n", name);
+		free(fileBuf);
+		return efalse;
+	}
+
+	colormapped = (header.imageType == TGA_COLORMAP || header.imageType == TGA_COLORMAP_RLE);
+	pixelSize	= (header.pixelSize + 7) / 8;
+
+	//Advance past the header, the image ID and any color map (which a
+	//true color image doesn't use)
+	skip	 = HEADER_SIZE + header.idLength;
+	colormap = buf + skip;
+	if(header.colormapType)
+		skip += header.colormapLength * ((header.colormapSize + 7) / 8);
+
+	if(header.width > TGA_MAX_SIZE || header.height > TGA_MAX_SIZE)
+	{
+		printf("Loading TGA: %s, failed. %dx%d is bigger than %d on a side.\n", name,
+				header.width, header.height, TGA_MAX_SIZE);
+		free(fileBuf);
+		return efalse;
 	}
-	else if(header.pixelSize == 24)
-		type = GL_RGB;
-	else
-		type = GL_RGBA;
 
 	//Determine size of image data chunk in bytes
-	dataSize = header.width * header.height * (header.pixelSize / 8);
+	dataSize = renderer_img_tgaSize(header.width, header.height, pixelSize);
 
-	//Set up our texture
-	*bpp 	 	= header.pixelSize;
-	*width  	= header.width;
-	*height 	= header.height;
+	if(dataSize == 0 || skip > fileSize || (colormapped && header.colormapLength == 0))
+	{
+		printf("Loading TGA: %s, failed. Bad header.\n", name);
+		free(fileBuf);
+		return efalse;
+	}
 
-	imageData = (byte *)malloc(dataSize);
-	rows	  = *height;
-	cols	  = *width;
+	buf += skip;
 
-	if(type == GL_RGB)
+	//Either way the pixels end up uncompressed, in the file's order.
+	//pixelBuf is set if they had to be copied to get there.
+	pixelBuf = NULL;
+
+	if(header.imageType == TGA_TRUECOLOR_RLE || header.imageType == TGA_COLORMAP_RLE)
 	{
-		for(i = rows-1; i >= 0; i--)
+		pixelBuf = (byte *)malloc(dataSize);
+
+		if(pixelBuf == NULL)
 		{
-			pixelBuf = imageData + (i * cols * 3);
-			for(j = 0; j < cols; j++)
-			{
-				blue 	= *buf++;
-				green 	= *buf++;
-				red		= *buf++;
+			printf("Loading TGA: %s, failed. Out of memory.\n", name);
+			free(fileBuf);
+			return efalse;
+		}
 
-				*pixelBuf++ = red;
-				*pixelBuf++ = green;
-				*pixelBuf++ = blue;
-			}
+		if(!renderer_img_expandRLE(buf, fileSize - skip, pixelBuf, dataSize, pixelSize))
+		{
+			printf("Loading TGA: %s, failed. RLE data is corrupt or cut short.\n", name);
+			free(pixelBuf);
+			free(fileBuf);
+			return efalse;
 		}
+
+		buf = pixelBuf;
 	}
-	else
+	else if(fileSize - skip < dataSize)
+	{
+		printf("Loading TGA: %s, failed. Image data cut short.\n", name);
+		free(fileBuf);
+		return efalse;
+	}
+
+	//Color mapped and 16 bit pixels become 24/32 bit BGR(A), and from
+	//there on they're the same as any other
+	packFlags = 0;
+
+	if(colormapped || pixelSize == 2)
 	{
-		for(i = rows-1; i >= 0; i--)
+		imageData = (byte *)malloc(renderer_img_tgaSize(header.width, header.height, bpp / 8));
+
+		if(imageData == NULL)
 		{
-			pixelBuf = imageData + (i * cols * 4);
-			for(j = 0; j < cols; j++)
-			{
-				blue 	= *buf++;
-				green 	= *buf++;
-				red		= *buf++;
-				alpha	= *buf++;
-
-				*pixelBuf++ = red;
-				*pixelBuf++ = green;
-				*pixelBuf++ = blue;
-				*pixelBuf++ = alpha;
-			}
+			printf("Loading TGA: %s, failed. Out of memory.\n", name);
+			free(pixelBuf);
+			free(fileBuf);
+			return efalse;
+		}
+
+		if(!renderer_img_expandPixels(name, &header, colormap, buf, imageData, bpp / 8, &oneBitAlpha))
+		{
+			free(imageData);
+			free(pixelBuf);
+			free(fileBuf);
+			return efalse;
 		}
+
+		free(pixelBuf);
+		pixelBuf = imageData;
+		buf		 = imageData;
+
+		if(packed16 && oneBitAlpha)
+			packFlags = IMAGE_PACKED16;
 	}
 
-	//Upload the texture to OpenGL
-	glGenTextures(1, glTexID);
-	glBindTexture(GL_TEXTURE_2D, *glTexID);
+	image->bpp 	  = bpp;
+	image->width  = header.width;
+	image->height = header.height;
 
-	//printf("%d\n", *glTexID);
+	if(native)
+	{
+		image->flags = IMAGE_BGR | packFlags | ((header.attributes & TGA_ORIGIN_TOP) ? 0 : IMAGE_BOTTOM_UP);
 
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		if(pixelBuf)
+		{
+			free(fileBuf);
+			image->data = pixelBuf;
+			__sync_fetch_and_add(&convertedLoads, 1);
+		}
+		else
+		{
+			//Nothing to free at all if it's in the pack
+			image->data	 = (byte *)buf;
+			image->block = fileBuf;
+
+			if(image->flags & IMAGE_BOTTOM_UP)
+				__sync_fetch_and_add(&convertedLoads, 1);
+			else
+				__sync_fetch_and_add(&zeroCopyLoads, 1);
+
+			if(fileBuf == NULL)
+				image->flags |= IMAGE_MAPPED;
+		}
+
+		image->numLevels = 1;
+		image->levels[0] = image->data;
+		return etrue;
+	}
+
+	imageData = (byte *)malloc(renderer_img_tgaSize(image->width, image->height, bpp / 8));
+
+	if(imageData == NULL)
+	{
+		printf("Loading TGA: %s, failed. Out of memory.\n", name);
+		free(pixelBuf);
+		free(fileBuf);
+		return efalse;
+	}
+
+	//Rows are stored bottom up unless the origin bit says otherwise
+	renderer_img_swizzleBGR(buf, imageData, image->width, image->height,
+			bpp / 8, !(header.attributes & TGA_ORIGIN_TOP));
+
+	free(pixelBuf);
+	free(fileBuf);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, type, *width, *height,
-			0, type, GL_UNSIGNED_BYTE, imageData);
+	image->flags	 = packFlags;
+	image->data		 = imageData;
+	image->numLevels = 1;
+	image->levels[0] = imageData;
+
+	__sync_fetch_and_add(&convertedLoads, 1);
 
 	//Header debugging
 
@@ -176,5 +498,268 @@ void renderer_img_loadTGA(char *name, int *glTexID, int *width, int *height, int
 	printf("X Origin: %d\n", 				header.xOrigin);
 	printf("Y Origin: %d\n", 				header.yOrigin);
 	*/
+
+	return etrue;
 }
 
+/*
+ * Function: renderer_img_peekTGA
+ * Description: Reads just the header, for the size of an image before
+ * it's loaded. Returns efalse for anything renderer_img_readTGA wouldn't
+ * take, without saying why, loading it properly will.
+ */
+eboolean renderer_img_peekTGA(char *name, int *width, int *height, int *bpp)
+{
+	byte		header[HEADER_SIZE];
+	const byte	*buf;
+	FILE		*file;
+	int			size;
+
+	buf = files_findAsset(name, &size);
+
+	if(buf == NULL)
+	{
+		file = files_openAsset(name, "rb");
+		if(file == NULL)
+			return efalse;
+
+		size = fread(header, 1, HEADER_SIZE, file);
+		fclose(file);
+
+		buf = header;
+	}
+
+	if(size < HEADER_SIZE)
+		return efalse;
+
+	//What it will be once it's decoded
+	*bpp = renderer_img_tgaBpp(buf);
+	if(!*bpp)
+		return efalse;
+
+	*width	= buf[12] | (buf[13] << 8);
+	*height	= buf[14] | (buf[15] << 8);
+
+	return renderer_img_tgaSize(*width, *height, 1) > 0;
+}
+
+/*
+ * Function: renderer_img_decodeTGA
+ * Description: Reads a TARGA image file into memory as RGB(A), top row
+ * first.
+ */
+eboolean renderer_img_decodeTGA(char *name, image_t *image)
+{
+	return renderer_img_readTGA(name, image, efalse);
+}
+
+/*
+ * Function: renderer_img_freeImage
+ */
+void renderer_img_freeImage(image_t *image)
+{
+	int i;
+
+	for(i = 1; i < image->numLevels; i++)
+		free(image->levels[i]);
+
+	if(!(image->flags & IMAGE_MAPPED))
+		free(image->block ? image->block : image->data);
+	image->data		 = NULL;
+	image->block	 = NULL;
+	image->numLevels = 0;
+}
+
+/*
+ * Function: renderer_img_reportLoads
+ */
+void renderer_img_reportLoads()
+{
+	printf("Textures: %d uploaded straight from the file, %d converted first\n",
+			zeroCopyLoads, convertedLoads);
+}
+
+/*
+ * Function: renderer_img_loadTGA
+ * Description: Loads a TARGA image file, uploads to GL, and returns the
+ * texture ID. GL takes the file's own byte and
+ * row order when it has BGRA, so the pixels are only converted without.
+ * Materials go through renderer_img_acquireTexture, so a file shared
+ * between them is only loaded once.
+ */
+void renderer_img_loadTGA(char *name, int *glTexID, int *width, int *height, int *bpp)
+{
+	texture_t texture;
+
+	if(!renderer_img_uploadTGA(name, &texture))
+		return;
+
+	*glTexID	= texture.glTexID;
+	*bpp		= texture.bpp;
+	*width		= texture.width;
+	*height		= texture.height;
+}
+
+/*
+ * Function: renderer_img_uploadTGA
+ * Description: renderer_img_loadTGA, filling in a whole texture.
+ */
+eboolean renderer_img_uploadTGA(char *name, texture_t *texture)
+{
+	image_t			image;
+
+	if(!renderer_img_readTGA(name, &image, glConfig.bgra))
+		return efalse;
+
+	renderer_img_applyQuality(&image);
+
+	//Set up our texture
+	texture->bpp 	 	= image.bpp;
+	texture->width  	= image.width;
+	texture->height 	= image.height;
+	texture->format		= renderer_img_imageFormat(&image);
+	texture->hash		= renderer_img_hashImage(&image);
+
+	renderer_img_buildMips(&image);
+
+	texture->numLevels	= image.numLevels;
+	texture->baseLevel	= 0;
+
+	renderer_img_uploadImage(&image, &texture->glTexID);
+	renderer_img_freeImage(&image);
+
+	return etrue;
+}
+
+/*
+ * Function: renderer_img_genTexture
+ * Description: Creates and binds a repeating GL texture, filtered
+ * trilinearly if it's going to get more than one level. The levels are
+ * up to the caller.
+ */
+void renderer_img_genTexture(int numLevels, int *glTexID)
+{
+	glGenTextures(1, (GLuint *)glTexID);
+	glBindTexture(GL_TEXTURE_2D, *glTexID);
+
+	renderer_img_texParams(numLevels);
+}
+
+/*
+ * Function: renderer_img_texParams
+ * Description: The parameters renderer_img_genTexture gives the bound
+ * texture, for one whose name was made earlier.
+ */
+void renderer_img_texParams(int numLevels)
+{
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+			numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	//A partial chain (it was cut short) still has to be complete as far
+	//as GL is concerned
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+}
+
+/*
+ * Function: renderer_img_uploadImage
+ * Description: Creates a repeating GL texture from a decoded image. If it
+ * has a mip chain, every level goes up and it is filtered trilinearly.
+ */
+void renderer_img_uploadImage(const image_t *image, int *glTexID)
+{
+	//Upload the texture to OpenGL
+	renderer_img_genTexture(image->numLevels, glTexID);
+	renderer_img_uploadLevels(image, 0);
+}
+
+/*
+ * Function: renderer_img_imageFormat
+ * Description: The internal format an image is uploaded with.
+ */
+int renderer_img_imageFormat(const image_t *image)
+{
+	if(image->flags & IMAGE_PACKED16)
+		return (image->bpp == 24) ? GL_RGB5 : GL_RGB5_A1;
+
+	return (image->bpp == 24) ? GL_RGB : GL_RGBA;
+}
+
+/*
+ * Function: renderer_img_uploadLevels
+ * Description: Sends the levels of an image from firstLevel down to the
+ * bound texture. BGR(A) images need glConfig.bgra. Bottom up levels are
+ * turned over in one pass through a scratch buffer first, so the texture
+ * always ends up top row first. Packed images go up as 16 bit textures.
+ * With a pixel unpack buffer bound, the level pointers are offsets into
+ * it, and the image has to be top row first already.
+ */
+void renderer_img_uploadLevels(const image_t *image, int firstLevel)
+{
+	GLuint			type, format, internalFormat;
+	int				i, y, width, height, rowSize;
+	byte			*flipped;
+
+	type		   = (image->bpp == 24) ? GL_RGB : GL_RGBA;
+	internalFormat = renderer_img_imageFormat(image);
+
+	if(image->flags & IMAGE_BGR)
+		format = (image->bpp == 24) ? GL_BGR : GL_BGRA;
+	else
+		format = type;
+
+	//Rows of RGB images aren't necessarily 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	width   = image->width;
+	height  = image->height;
+	flipped = NULL;
+
+	for(i = 0; i < image->numLevels; i++)
+	{
+		if(i < firstLevel)
+		{
+			width  = width  > 1 ? width  / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			continue;
+		}
+
+		if(image->flags & IMAGE_BOTTOM_UP)
+		{
+			rowSize = width * (image->bpp / 8);
+
+			//Levels only get smaller, so the first one sent sizes the buffer
+			if(flipped == NULL)
+				flipped = (byte *)malloc(rowSize * height);
+
+			if(flipped != NULL)
+			{
+				for(y = 0; y < height; y++)
+					memcpy(flipped + (height - 1 - y) * rowSize, image->levels[i] + y * rowSize, rowSize);
+
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height,
+						0, format, GL_UNSIGNED_BYTE, flipped);
+			}
+			else
+			{
+				//No memory to turn it over in, so it goes up a row at a time
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height,
+						0, format, GL_UNSIGNED_BYTE, NULL);
+
+				for(y = 0; y < height; y++)
+					glTexSubImage2D(GL_TEXTURE_2D, i, 0, height - 1 - y, width, 1,
+							format, GL_UNSIGNED_BYTE, image->levels[i] + y * rowSize);
+			}
+		}
+		else
+			glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height,
+					0, format, GL_UNSIGNED_BYTE, image->levels[i]);
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	free(flipped);
+}
@@ -0,0 +1,534 @@
+/*
+===========================================================================
+File:		renderer_img_cache.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Every bitmap gets decoded and uploaded once, however many
+			materials use it. Entries are found through a hash of the
+			normalized path and dropped when the last handle is released.
+
+			Paths aren't case folded, two names that only differ in case
+			are two files as far as the cache is concerned.
+
+			Streamed textures only ever have two states: their levels up
+			to STREAM_START_SIZE, or all of them. A texture that gets drawn
+			is queued for the rest, and if that would go over the budget
+			the ones drawn longest ago are dropped back to the start level
+			to make room. GL can't free single levels, so dropping them is
+			moving the base level past them and then shrinking them to 0x0.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_materials.h"
+#include "headers/renderer_atlas.h"
+
+typedef struct
+{
+	char		name[MAX_FILEPATH];
+	texture_t	texture;
+	int			refCount;
+
+	//Next entry in the same bucket, or on the free list. Off by one, so 0
+	//is the end of the chain.
+	int			next;
+
+	//Streaming: the last frame it was drawn in (far enough back to be
+	//evicted until it has been), the level it starts out at and drops
+	//back to, and the level it's waiting on (-1 for none)
+	int			lastUsed, startLevel, requested;
+}
+textureEntry_t;
+
+static textureEntry_t	entries[MAX_TEXTURES];
+static int				buckets[TEXTURE_HASH_SIZE];
+static int				numEntries = 0, freeList = 0;
+static int				sharedLoads = 0;
+
+//0 is no streaming
+static int				streamBudget = 0;
+static int				streamFrame = 0;
+static int				residentBytes = 0, peakBytes = 0, streamRequests = 0, streamEvictions = 0;
+
+/*
+ * cache_normalize
+ * Forward slashes only, no empty or "." components, and ".." folded into
+ * the component before it where there is one.
+ */
+static void cache_normalize(const char *name, char *out, int size)
+{
+	char	path[MAX_FILEPATH];
+	char	*parts[MAX_FILEPATH / 2], *part;
+	int		numParts, i, len;
+
+	strncpy(path, name, sizeof(path) - 1);
+	path[sizeof(path) - 1] = '\0';
+
+	for(i = 0; path[i]; i++)
+		if(path[i] == '\\')
+			path[i] = '/';
+
+	numParts = 0;
+
+	for(part = strtok(path, "/"); part != NULL; part = strtok(NULL, "/"))
+	{
+		if(!strcmp(part, "."))
+			continue;
+
+		if(!strcmp(part, "..") && numParts > 0 && strcmp(parts[numParts - 1], ".."))
+		{
+			numParts--;
+			continue;
+		}
+
+		parts[numParts++] = part;
+	}
+
+	len = 0;
+	out[0] = '\0';
+
+	if(name[0] == '/' || name[0] == '\\')
+		out[len++] = '/';
+
+	for(i = 0; i < numParts && len < size - 1; i++)
+		len += snprintf(out + len, size - len, i ? "/%s" : "%s", parts[i]);
+
+	out[size - 1] = '\0';
+}
+
+/*
+ * cache_hash
+ * FNV-1a
+ */
+static unsigned int cache_hash(const char *key)
+{
+	unsigned int hash = 2166136261u;
+
+	while(*key)
+	{
+		hash ^= (byte)*key++;
+		hash *= 16777619u;
+	}
+
+	return hash & (TEXTURE_HASH_SIZE - 1);
+}
+
+/*
+ * cache_startLevel
+ * The first level no bigger than STREAM_START_SIZE either way, and how
+ * many levels the whole chain has.
+ */
+static int cache_startLevel(int width, int height, int *numLevels)
+{
+	int level;
+
+	level	   = -1;
+	*numLevels = 0;
+
+	while(*numLevels < MAX_IMAGE_LEVELS)
+	{
+		if(level < 0 && width <= STREAM_START_SIZE && height <= STREAM_START_SIZE)
+			level = *numLevels;
+
+		(*numLevels)++;
+
+		if(width == 1 && height == 1)
+			break;
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return level < 0 ? *numLevels - 1 : level;
+}
+
+/*
+ * cache_load
+ * A cooked version if there is one. Otherwise same as a material used to
+ * do it: onto an atlas page if allowed and it fits, otherwise a texture of
+ * its own with a mip chain. Those are loaded in the background if the
+ * loader is running, and streamed if there's a budget.
+ */
+static eboolean cache_load(char *name, eboolean atlas, texture_t *texture, int *startLevel)
+{
+	image_t		image;
+	eboolean	peeked;
+
+	texture->glTexID   = 0;
+	texture->atlased   = efalse;
+	texture->streamed  = efalse;
+	texture->numLevels = 1;
+	texture->baseLevel = 0;
+	texture->hash	   = 0;
+	*startLevel		   = 0;
+
+	if(renderer_img_loadCooked(name, atlas, texture))
+		return etrue;
+
+	peeked = renderer_img_peekTGA(name, &texture->width, &texture->height, &texture->bpp);
+
+	//The size it will be once the loader has shrunk it, and the format it
+	//goes up as (the loader puts that right if it turns out packed)
+	if(peeked)
+	{
+		renderer_img_qualityLevels(&texture->width, &texture->height);
+		texture->format = (texture->bpp == 24) ? GL_RGB : GL_RGBA;
+	}
+
+	if(peeked && (!atlas || texture->width > ATLAS_MAX_IMAGE || texture->height > ATLAS_MAX_IMAGE))
+	{
+		//Base levels are GL 1.2
+		if(streamBudget > 0 && (glConfig.versionMajor > 1 || glConfig.versionMinor >= 2))
+		{
+			*startLevel			= cache_startLevel(texture->width, texture->height, &texture->numLevels);
+			texture->baseLevel	= texture->numLevels;
+			texture->streamed	= etrue;
+
+			if(renderer_img_queueTGA(name, texture, *startLevel))
+				return etrue;
+
+			texture->streamed = efalse;
+			*startLevel		  = 0;
+		}
+
+		if(renderer_img_queueTGA(name, texture, 0))
+			return etrue;
+	}
+
+	if(!atlas)
+		return renderer_img_uploadTGA(name, texture);
+
+	if(!renderer_img_decodeTGA(name, &image))
+		return efalse;
+
+	renderer_img_applyQuality(&image);
+
+	texture->width	= image.width;
+	texture->height	= image.height;
+	texture->bpp	= image.bpp;
+	texture->hash	= renderer_img_hashImage(&image);
+
+	//Atlas pages stay at a single level, mips would bleed neighbours
+	//into each other
+	if(renderer_atlas_addImage(&image, &texture->glTexID, texture->atlas))
+	{
+		texture->atlased = etrue;
+		texture->format	 = GL_RGBA;
+	}
+	else
+	{
+		renderer_img_buildMips(&image);
+		renderer_img_uploadImage(&image, &texture->glTexID);
+
+		texture->format	   = renderer_img_imageFormat(&image);
+		texture->numLevels = image.numLevels;
+	}
+
+	renderer_img_freeImage(&image);
+	return etrue;
+}
+
+/*
+ * renderer_img_acquireTexture
+ * Returns a handle to the texture for a bitmap, loading it only if nothing
+ * else is holding it. atlas says whether the caller can use it off an
+ * atlas page (its texture coordinates don't wrap). Returns NO_TEXTURE if
+ * it can't be loaded. Every handle is given back with
+ * renderer_img_releaseTexture.
+ */
+int renderer_img_acquireTexture(char *name, eboolean atlas)
+{
+	char			key[MAX_FILEPATH];
+	unsigned int	hash;
+	int				i;
+	textureEntry_t	*entry;
+
+	cache_normalize(name, key, sizeof(key));
+	hash = cache_hash(key);
+
+	//A texture of its own does for anyone, one on an atlas page only for
+	//those that asked for it
+	for(i = buckets[hash]; i; i = entries[i - 1].next)
+	{
+		entry = &entries[i - 1];
+
+		if(!strcmp(entry->name, key) && (atlas || !entry->texture.atlased))
+		{
+			entry->refCount++;
+			sharedLoads++;
+			return i - 1;
+		}
+	}
+
+	if(freeList)
+	{
+		i = freeList - 1;
+		freeList = entries[i].next;
+	}
+	else if(numEntries < MAX_TEXTURES)
+		i = numEntries++;
+	else
+	{
+		printf("Texture cache: full, can't load %s\n", name);
+		return NO_TEXTURE;
+	}
+
+	entry = &entries[i];
+
+	if(!cache_load(name, atlas, &entry->texture, &entry->startLevel))
+	{
+		entry->next = freeList;
+		freeList	= i + 1;
+		return NO_TEXTURE;
+	}
+
+	strcpy(entry->name, key);
+	entry->refCount	 = 1;
+	entry->next		 = buckets[hash];
+	entry->lastUsed	 = streamFrame - STREAM_IDLE_FRAMES;
+	entry->requested = -1;
+	buckets[hash]	 = i + 1;
+
+	return i;
+}
+
+/*
+ * renderer_img_getTexture
+ */
+const texture_t *renderer_img_getTexture(int handle)
+{
+	return &entries[handle].texture;
+}
+
+/*
+ * renderer_img_releaseTexture
+ * Deletes the GL texture along with the last handle. Space on an atlas
+ * page isn't given back, the packer can't take images out.
+ */
+void renderer_img_releaseTexture(int handle)
+{
+	textureEntry_t	*entry;
+	int				*link;
+
+	if(handle == NO_TEXTURE)
+		return;
+
+	entry = &entries[handle];
+
+	if(--entry->refCount > 0)
+		return;
+
+	if(!entry->texture.atlased)
+	{
+		renderer_img_cancelLoad(entry->texture.glTexID);
+		glDeleteTextures(1, (GLuint *)&entry->texture.glTexID);
+	}
+
+	for(link = &buckets[cache_hash(entry->name)]; *link != handle + 1; link = &entries[*link - 1].next)
+		;
+
+	*link = entry->next;
+
+	entry->next = freeList;
+	freeList	= handle + 1;
+}
+
+/*
+ * renderer_img_setTextureBudget
+ * Turns streaming on for textures loaded from here on, with 0 turning it
+ * off. Only what streamed textures take up counts against it.
+ */
+void renderer_img_setTextureBudget(int bytes)
+{
+	streamBudget = bytes;
+}
+
+/*
+ * renderer_img_touchTexture
+ * Marks a texture as drawn this frame.
+ */
+void renderer_img_touchTexture(int handle)
+{
+	if(handle != NO_TEXTURE)
+		entries[handle].lastUsed = streamFrame;
+}
+
+/*
+ * cache_evict
+ * Drops a texture back to its start level.
+ */
+static void cache_evict(textureEntry_t *entry)
+{
+	texture_t	*texture = &entry->texture;
+	int			i;
+
+	glBindTexture(GL_TEXTURE_2D, texture->glTexID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry->startLevel);
+
+	for(i = texture->baseLevel; i < entry->startLevel; i++)
+		glTexImage2D(GL_TEXTURE_2D, i, texture->format, 0, 0,
+				0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	residentBytes -= renderer_img_textureBytes(texture, texture->baseLevel) -
+			renderer_img_textureBytes(texture, entry->startLevel);
+	texture->baseLevel = entry->startLevel;
+	streamEvictions++;
+}
+
+/*
+ * cache_leastRecent
+ * The streamed texture with all its levels that was drawn longest ago,
+ * as long as that's at least STREAM_IDLE_FRAMES ago. NULL if there isn't
+ * one.
+ */
+static textureEntry_t * cache_leastRecent()
+{
+	textureEntry_t	*entry, *oldest;
+	int				i;
+
+	oldest = NULL;
+
+	for(i = 0; i < numEntries; i++)
+	{
+		entry = &entries[i];
+
+		if(entry->refCount <= 0 || !entry->texture.streamed || entry->requested >= 0 ||
+		   entry->texture.baseLevel >= entry->startLevel || streamFrame - entry->lastUsed < STREAM_IDLE_FRAMES)
+			continue;
+
+		if(oldest == NULL || entry->lastUsed < oldest->lastUsed)
+			oldest = entry;
+	}
+
+	return oldest;
+}
+
+/*
+ * renderer_img_updateStreaming
+ * Call once a frame from the GL thread, after renderer_img_updateLoads.
+ * Asks for the rest of the levels of whatever was drawn last frame.
+ */
+void renderer_img_updateStreaming()
+{
+	textureEntry_t	*entry, *victim;
+	texture_t		*texture;
+	int				i, numRequests, pendingBytes, needed;
+
+	if(streamBudget <= 0)
+		return;
+
+	//Tallied from scratch, the loader updates baseLevel behind our back
+	residentBytes = 0;
+	pendingBytes  = 0;
+
+	for(i = 0; i < numEntries; i++)
+	{
+		entry	= &entries[i];
+		texture	= &entry->texture;
+
+		if(entry->refCount <= 0 || !texture->streamed)
+			continue;
+
+		if(entry->requested >= 0 && texture->baseLevel <= entry->requested)
+			entry->requested = -1;
+
+		residentBytes += renderer_img_textureBytes(texture, texture->baseLevel);
+
+		if(entry->requested >= 0)
+			pendingBytes += renderer_img_textureBytes(texture, entry->requested) -
+					renderer_img_textureBytes(texture, texture->baseLevel);
+	}
+
+	for(i = 0, numRequests = 0; i < numEntries && numRequests < STREAM_REQUESTS_PER_FRAME; i++)
+	{
+		entry	= &entries[i];
+		texture	= &entry->texture;
+
+		//Still waiting on its first levels counts as having a request in
+		if(entry->refCount <= 0 || !texture->streamed || entry->requested >= 0 ||
+		   texture->baseLevel == 0 || texture->baseLevel == texture->numLevels ||
+		   streamFrame - entry->lastUsed > 1)
+			continue;
+
+		needed = renderer_img_textureBytes(texture, 0) - renderer_img_textureBytes(texture, texture->baseLevel);
+
+		while(residentBytes + pendingBytes + needed > streamBudget && (victim = cache_leastRecent()) != NULL)
+			cache_evict(victim);
+
+		if(residentBytes + pendingBytes + needed > streamBudget)
+			continue;
+
+		if(!renderer_img_queueTGA(entry->name, texture, 0))
+			break;
+
+		entry->requested  = 0;
+		pendingBytes	 += needed;
+		streamRequests++;
+		numRequests++;
+	}
+
+	if(residentBytes > peakBytes)
+		peakBytes = residentBytes;
+
+	streamFrame++;
+}
+
+/*
+ * renderer_img_reportStreaming
+ */
+void renderer_img_reportStreaming()
+{
+	if(streamBudget <= 0)
+		return;
+
+	printf("Texture streaming: %d KB resident, %d KB at most, %d KB budget, %d requests, %d evictions\n",
+			residentBytes / 1024, peakBytes / 1024, streamBudget / 1024, streamRequests, streamEvictions);
+}
+
+/*
+ * renderer_img_reportTextures
+ */
+void renderer_img_reportTextures()
+{
+	int i, live;
+
+	for(i = 0, live = 0; i < numEntries; i++)
+		if(entries[i].refCount > 0)
+			live++;
+
+	printf("Texture cache: %d textures loaded, %d requests shared one\n", live, sharedLoads);
+}
+
+/*
+ * renderer_img_getNumTextureHandles
+ * One past the highest handle there has been, for walking every texture.
+ */
+int renderer_img_getNumTextureHandles()
+{
+	return numEntries;
+}
+
+/*
+ * renderer_img_getTextureName
+ * The normalized path, NULL if nothing is holding the handle.
+ */
+const char *renderer_img_getTextureName(int handle)
+{
+	return entries[handle].refCount > 0 ? entries[handle].name : NULL;
+}
+
+/*
+ * renderer_img_getTextureUsers
+ */
+int renderer_img_getTextureUsers(int handle)
+{
+	return entries[handle].refCount;
+}
@@ -0,0 +1,352 @@
+/*
+===========================================================================
+File:		renderer_img_cook.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Cooked textures: the whole mip chain block compressed ahead of
+			time, in a DDS file next to the source (foo.tga -> foo.dds).
+			Only the subset we write is read back: DXT1 or DXT5, one 2D
+			image, top row first.
+
+			Images with any alpha below 255 are BC3, everything else BC1.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_materials.h"
+#include "headers/renderer_atlas.h"
+
+#define DDS_MAGIC			0x20534444	//"DDS "
+#define DDS_HEADER_SIZE		124
+#define DDS_FILE_HEADER		(4 + DDS_HEADER_SIZE)
+
+#define DDSD_CAPS			0x1
+#define DDSD_HEIGHT			0x2
+#define DDSD_WIDTH			0x4
+#define DDSD_PIXELFORMAT	0x1000
+#define DDSD_MIPMAPCOUNT	0x20000
+#define DDSD_LINEARSIZE		0x80000
+#define DDPF_FOURCC			0x4
+#define DDSCAPS_COMPLEX		0x8
+#define DDSCAPS_TEXTURE		0x1000
+#define DDSCAPS_MIPMAP		0x400000
+
+#define FOURCC_DXT1			0x31545844
+#define FOURCC_DXT5			0x35545844
+
+//Where things are in the header, counted in 32 bit words after the magic
+#define DDS_FLAGS			1
+#define DDS_HEIGHT			2
+#define DDS_WIDTH			3
+#define DDS_LINEARSIZE		4
+#define DDS_MIPCOUNT		6
+#define DDS_PF_SIZE			18
+#define DDS_PF_FLAGS		19
+#define DDS_PF_FOURCC		20
+#define DDS_CAPS			26
+
+static eboolean cookOnLoad = efalse;
+
+/*
+ * cook_cookedName
+ * The source name with its extension swapped for .dds.
+ */
+static void cook_cookedName(const char *name, char *out, int size)
+{
+	const char *dot, *slash;
+
+	dot	  = strrchr(name, '.');
+	slash = strrchr(name, '/');
+
+	if(dot == NULL || (slash != NULL && dot < slash))
+		dot = name + strlen(name);
+
+	snprintf(out, size, "%.*s.dds", (int)(dot - name), name);
+}
+
+/*
+ * cook_upToDate
+ * A cooked file with no source next to it is as good as it's going to get.
+ */
+static eboolean cook_upToDate(const char *cooked, const char *source)
+{
+	struct stat cookedSt, sourceSt;
+
+	if(stat(cooked, &cookedSt))
+		return efalse;
+
+	if(stat(source, &sourceSt))
+		return etrue;
+
+	return cookedSt.st_mtime >= sourceSt.st_mtime;
+}
+
+/*
+ * renderer_img_setCookOnLoad
+ * With this on, a texture without an up to date cooked file gets cooked
+ * the first time it's loaded.
+ */
+void renderer_img_setCookOnLoad(eboolean enable)
+{
+	cookOnLoad = enable;
+}
+
+/*
+ * renderer_img_cookImage
+ * Compresses every level of an image and writes them out. The image has
+ * to be RGB(A), top row first.
+ */
+eboolean renderer_img_cookImage(const image_t *image, char *cookedName)
+{
+	unsigned int	header[DDS_HEADER_SIZE / 4], magic;
+	int				format, comps, i, width, height, size, total;
+	byte			*blocks;
+	FILE			*file;
+
+	comps  = image->bpp / 8;
+	format = DXT_BC1;
+
+	if(comps == 4)
+	{
+		for(i = 0; i < image->width * image->height; i++)
+		{
+			if(image->data[i * 4 + 3] != 255)
+			{
+				format = DXT_BC3;
+				break;
+			}
+		}
+	}
+
+	file = fopen(cookedName, "wb");
+	if(file == NULL)
+	{
+		printf("Cooking: could not write %s\n", cookedName);
+		return efalse;
+	}
+
+	memset(header, 0, sizeof(header));
+	header[0]				= DDS_HEADER_SIZE;
+	header[DDS_FLAGS]		= DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT |
+							  DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header[DDS_HEIGHT]		= image->height;
+	header[DDS_WIDTH]		= image->width;
+	header[DDS_LINEARSIZE]	= renderer_img_dxtSize(image->width, image->height, format);
+	header[DDS_MIPCOUNT]	= image->numLevels;
+	header[DDS_PF_SIZE]		= 32;
+	header[DDS_PF_FLAGS]	= DDPF_FOURCC;
+	header[DDS_PF_FOURCC]	= (format == DXT_BC1) ? FOURCC_DXT1 : FOURCC_DXT5;
+	header[DDS_CAPS]		= DDSCAPS_TEXTURE | (image->numLevels > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	magic = DDS_MAGIC;
+	fwrite(&magic, 4, 1, file);
+	fwrite(header, sizeof(header), 1, file);
+
+	blocks = (byte *)malloc(header[DDS_LINEARSIZE]);
+	width  = image->width;
+	height = image->height;
+	total  = 0;
+
+	for(i = 0; i < image->numLevels; i++)
+	{
+		size = renderer_img_dxtSize(width, height, format);
+
+		renderer_img_encodeDXT(image->levels[i], width, height, comps, blocks, format);
+		fwrite(blocks, size, 1, file);
+		total += size;
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	free(blocks);
+	fclose(file);
+
+	printf("Cooked %s: %dx%d %s, %d levels, %d KB\n", cookedName, image->width, image->height,
+			format == DXT_BC1 ? "BC1" : "BC3", image->numLevels, total / 1024);
+	return etrue;
+}
+
+/*
+ * renderer_img_cookTGA
+ * Cooks a TGA into the .dds next to it.
+ */
+eboolean renderer_img_cookTGA(char *name)
+{
+	char		cookedName[MAX_FILEPATH];
+	image_t		image;
+	eboolean	cooked;
+
+	if(!renderer_img_decodeTGA(name, &image))
+		return efalse;
+
+	renderer_img_buildMips(&image);
+
+	cook_cookedName(name, cookedName, sizeof(cookedName));
+	cooked = renderer_img_cookImage(&image, cookedName);
+
+	renderer_img_freeImage(&image);
+	return cooked;
+}
+
+/*
+ * cook_upload
+ * Straight to GL if it takes S3TC, otherwise each level is decoded first.
+ * Returns the internal format it went up as.
+ */
+static int cook_upload(const byte *blocks, int width, int height, int numLevels, int format, int *glTexID)
+{
+	image_t		image;
+	GLenum		internalFormat;
+	int			i, size;
+
+	if(glConfig.textureCompressionS3TC)
+	{
+		internalFormat = (format == DXT_BC1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		renderer_img_genTexture(numLevels, glTexID);
+
+		for(i = 0; i < numLevels; i++)
+		{
+			size = renderer_img_dxtSize(width, height, format);
+			qglCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, size, blocks);
+
+			blocks += size;
+			width	= width  > 1 ? width  / 2 : 1;
+			height	= height > 1 ? height / 2 : 1;
+		}
+
+		return internalFormat;
+	}
+
+	memset(&image, 0, sizeof(image));
+	image.width		= width;
+	image.height	= height;
+	image.bpp		= (format == DXT_BC1) ? 24 : 32;
+	image.numLevels	= numLevels;
+
+	for(i = 0; i < numLevels; i++)
+	{
+		image.levels[i] = (byte *)malloc(width * height * (image.bpp / 8));
+		renderer_img_decodeDXT(blocks, width, height, image.levels[i], image.bpp / 8, format);
+
+		blocks += renderer_img_dxtSize(width, height, format);
+		width	= width  > 1 ? width  / 2 : 1;
+		height	= height > 1 ? height / 2 : 1;
+	}
+
+	image.data = image.levels[0];
+
+	renderer_img_uploadImage(&image, glTexID);
+	renderer_img_freeImage(&image);
+
+	return renderer_img_imageFormat(&image);
+}
+
+/*
+ * renderer_img_loadCooked
+ * Loads the cooked version of a texture if there is one, cooking it first
+ * if that's turned on. One in the asset pack is always used. With atlas
+ * set, nothing gets cooked and anything small enough for an atlas page is
+ * left for one. Returns efalse if the caller should load the source
+ * instead.
+ */
+eboolean renderer_img_loadCooked(char *name, eboolean atlas, texture_t *texture)
+{
+	char			cookedName[MAX_FILEPATH];
+	unsigned int	header[DDS_HEADER_SIZE / 4], magic;
+	int				width, height, numLevels, format, i, w, h, dataSize, fileSize, skip, skipSize;
+	const byte		*file;
+	byte			*fileBuf;
+
+	cook_cookedName(name, cookedName, sizeof(cookedName));
+
+	if(!files_findAsset(cookedName, &fileSize) && !cook_upToDate(cookedName, name))
+	{
+		if(atlas || !cookOnLoad || !renderer_img_cookTGA(name))
+			return efalse;
+	}
+
+	file = files_loadAsset(cookedName, &fileSize, &fileBuf);
+	if(file == NULL || fileSize < DDS_FILE_HEADER)
+	{
+		free(fileBuf);
+		return efalse;
+	}
+
+	memcpy(&magic, file, 4);
+	memcpy(header, file + 4, sizeof(header));
+
+	width	  = header[DDS_WIDTH];
+	height	  = header[DDS_HEIGHT];
+	numLevels = (header[DDS_FLAGS] & DDSD_MIPMAPCOUNT) && header[DDS_MIPCOUNT] ? header[DDS_MIPCOUNT] : 1;
+	format	  = (header[DDS_PF_FOURCC] == FOURCC_DXT1) ? DXT_BC1 :
+				(header[DDS_PF_FOURCC] == FOURCC_DXT5) ? DXT_BC3 : 0;
+
+	if(magic != DDS_MAGIC || header[0] != DDS_HEADER_SIZE || !(header[DDS_PF_FLAGS] & DDPF_FOURCC) ||
+	   !format || width <= 0 || height <= 0 || width > 32768 || height > 32768 ||
+	   numLevels > MAX_IMAGE_LEVELS)
+	{
+		printf("Loading cooked texture: %s, failed. Not a DXT1/DXT5 texture we can read.\n", cookedName);
+		free(fileBuf);
+		return efalse;
+	}
+
+	if(atlas && width <= ATLAS_MAX_IMAGE && height <= ATLAS_MAX_IMAGE)
+	{
+		free(fileBuf);
+		return efalse;
+	}
+
+	for(i = 0, dataSize = 0, w = width, h = height; i < numLevels; i++)
+	{
+		dataSize += renderer_img_dxtSize(w, h, format);
+		w = w > 1 ? w / 2 : 1;
+		h = h > 1 ? h / 2 : 1;
+	}
+
+	if(fileSize - DDS_FILE_HEADER < dataSize)
+	{
+		printf("Loading cooked texture: %s, failed. Cut short.\n", cookedName);
+		free(fileBuf);
+		return efalse;
+	}
+
+	//Below full quality the finest levels are just skipped, as far as the
+	//file goes (a single level is kept whatever size it is)
+	w	 = width;
+	h	 = height;
+	skip = renderer_img_qualityLevels(&w, &h);
+	if(skip > numLevels - 1)
+		skip = numLevels - 1;
+
+	for(i = 0, skipSize = 0; i < skip; i++)
+	{
+		skipSize += renderer_img_dxtSize(width, height, format);
+		width	  = width  > 1 ? width  / 2 : 1;
+		height	  = height > 1 ? height / 2 : 1;
+	}
+
+	numLevels -= skip;
+	renderer_img_countQuality(dataSize, dataSize - skipSize);
+
+	texture->format = cook_upload(file + DDS_FILE_HEADER + skipSize, width, height, numLevels, format,
+			&texture->glTexID);
+	texture->hash	= renderer_img_hashBytes(file + DDS_FILE_HEADER + skipSize, dataSize - skipSize);
+	free(fileBuf);
+
+	texture->width	   = width;
+	texture->height	   = height;
+	texture->bpp	   = (format == DXT_BC1) ? 24 : 32;
+	texture->atlased   = efalse;
+	texture->numLevels = numLevels;
+	texture->baseLevel = 0;
+
+	return etrue;
+}
@@ -0,0 +1,511 @@
+/*
+===========================================================================
+File:		renderer_img_dxt.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		BC1 (DXT1) and BC3 (DXT5) block compression. Colour endpoints
+			are a range fit: the block's principal axis through its mean,
+			from the lowest to the highest projection onto it. Each pixel
+			then takes whichever of the 4 palette entries is nearest.
+
+			The endpoint fit is shared, only the nearest entry search has
+			a vector version. Distances are whole numbers well inside a
+			float's mantissa, so both give the same bytes.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_cpuinfo.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+#include "headers/simd.h"
+
+#include "headers/renderer_materials.h"
+
+#ifdef SIMD_X86
+#include <emmintrin.h>
+#endif
+
+//Power iterations for the principal axis, plenty for a 3x3 matrix
+#define DXT_AXIS_ITERATIONS 8
+
+typedef struct
+{
+	float	r[16], g[16], b[16];
+	byte	a[16];
+}
+dxtBlock_t;
+
+typedef void (*dxtIndicesFunc_t)(const dxtBlock_t *block, const int palette[4][3], int *indices);
+
+static void dxt_indicesScalar(const dxtBlock_t *block, const int palette[4][3], int *indices);
+
+#ifdef SIMD_X86
+static void dxt_indicesSSE2(const dxtBlock_t *block, const int palette[4][3], int *indices);
+#endif
+
+static dxtIndicesFunc_t dxt_indices = dxt_indicesScalar;
+
+/*
+ * renderer_img_initDXT
+ */
+void renderer_img_initDXT()
+{
+#ifdef SIMD_X86
+	if(SDL_HasSSE2())
+		dxt_indices = dxt_indicesSSE2;
+#endif
+}
+
+/*
+ * renderer_img_dxtSize
+ * Bytes for one level. Partial blocks at the edges count as whole ones.
+ */
+int renderer_img_dxtSize(int width, int height, int format)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * (format == DXT_BC1 ? 8 : 16);
+}
+
+/*
+ * dxt_fetchBlock
+ * Off the right or bottom edge, the last column/row is repeated.
+ */
+static void dxt_fetchBlock(const byte *pixels, int width, int height, int comps,
+		int bx, int by, dxtBlock_t *block)
+{
+	int			x, y, sx, sy, i;
+	const byte	*src;
+
+	for(y = 0, i = 0; y < 4; y++)
+	{
+		sy = (by + y < height) ? by + y : height - 1;
+
+		for(x = 0; x < 4; x++, i++)
+		{
+			sx	= (bx + x < width) ? bx + x : width - 1;
+			src	= pixels + (sy * width + sx) * comps;
+
+			block->r[i] = src[0];
+			block->g[i] = src[1];
+			block->b[i] = src[2];
+			block->a[i] = (comps == 4) ? src[3] : 255;
+		}
+	}
+}
+
+/*
+ * dxt_to565
+ */
+static int dxt_to565(float r, float g, float b)
+{
+	int r5, g6, b5;
+
+	r5 = (int)(r * 31.0 / 255.0 + 0.5);
+	g6 = (int)(g * 63.0 / 255.0 + 0.5);
+	b5 = (int)(b * 31.0 / 255.0 + 0.5);
+
+	return (r5 << 11) | (g6 << 5) | b5;
+}
+
+/*
+ * dxt_from565
+ * Replicates the top bits into the bottom ones, like the hardware does.
+ */
+static void dxt_from565(int c, int *rgb)
+{
+	rgb[0] = (c >> 11) & 31;
+	rgb[1] = (c >> 5)  & 63;
+	rgb[2] =  c		   & 31;
+
+	rgb[0] = (rgb[0] << 3) | (rgb[0] >> 2);
+	rgb[1] = (rgb[1] << 2) | (rgb[1] >> 4);
+	rgb[2] = (rgb[2] << 3) | (rgb[2] >> 2);
+}
+
+/*
+ * dxt_palette
+ * Both endpoints plus the two colours a third of the way in from each.
+ */
+static void dxt_palette(int c0, int c1, int palette[4][3])
+{
+	int i;
+
+	dxt_from565(c0, palette[0]);
+	dxt_from565(c1, palette[1]);
+
+	for(i = 0; i < 3; i++)
+	{
+		palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+		palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+	}
+}
+
+/*
+ * dxt_fitEndpoints
+ */
+static void dxt_fitEndpoints(const dxtBlock_t *block, int *c0, int *c1)
+{
+	float	mean[3], cov[6], axis[3], next[3], d[3], t, tMin, tMax, scale;
+	float	lo[3], hi[3];
+	int		i, j;
+
+	mean[0] = mean[1] = mean[2] = 0.0;
+	for(i = 0; i < 16; i++)
+	{
+		mean[0] += block->r[i];
+		mean[1] += block->g[i];
+		mean[2] += block->b[i];
+	}
+	mean[0] /= 16.0;
+	mean[1] /= 16.0;
+	mean[2] /= 16.0;
+
+	for(j = 0; j < 6; j++)
+		cov[j] = 0.0;
+
+	for(i = 0; i < 16; i++)
+	{
+		d[0] = block->r[i] - mean[0];
+		d[1] = block->g[i] - mean[1];
+		d[2] = block->b[i] - mean[2];
+
+		cov[0] += d[0] * d[0];
+		cov[1] += d[0] * d[1];
+		cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1];
+		cov[4] += d[1] * d[2];
+		cov[5] += d[2] * d[2];
+	}
+
+	//Power iteration, rescaled by the biggest component instead of
+	//normalized
+	axis[0] = axis[1] = axis[2] = 1.0;
+
+	for(j = 0; j < DXT_AXIS_ITERATIONS; j++)
+	{
+		next[0] = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		next[1] = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		next[2] = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+		scale = fabs(next[0]);
+		if(fabs(next[1]) > scale) scale = fabs(next[1]);
+		if(fabs(next[2]) > scale) scale = fabs(next[2]);
+
+		//Every pixel the same colour
+		if(scale < 1e-6)
+		{
+			*c0 = *c1 = dxt_to565(mean[0], mean[1], mean[2]);
+			return;
+		}
+
+		axis[0] = next[0] / scale;
+		axis[1] = next[1] / scale;
+		axis[2] = next[2] / scale;
+	}
+
+	scale = 1.0 / (axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+	tMin = tMax = 0.0;
+	for(i = 0; i < 16; i++)
+	{
+		t = ((block->r[i] - mean[0]) * axis[0] + (block->g[i] - mean[1]) * axis[1] +
+			 (block->b[i] - mean[2]) * axis[2]) * scale;
+
+		if(t < tMin) tMin = t;
+		if(t > tMax) tMax = t;
+	}
+
+	for(j = 0; j < 3; j++)
+	{
+		lo[j] = mean[j] + axis[j] * tMin;
+		hi[j] = mean[j] + axis[j] * tMax;
+
+		lo[j] = lo[j] < 0.0 ? 0.0 : (lo[j] > 255.0 ? 255.0 : lo[j]);
+		hi[j] = hi[j] < 0.0 ? 0.0 : (hi[j] > 255.0 ? 255.0 : hi[j]);
+	}
+
+	*c0 = dxt_to565(hi[0], hi[1], hi[2]);
+	*c1 = dxt_to565(lo[0], lo[1], lo[2]);
+}
+
+/*
+ * dxt_indicesScalar
+ * Nearest palette entry for each pixel, the lower one on a tie.
+ */
+static void dxt_indicesScalar(const dxtBlock_t *block, const int palette[4][3], int *indices)
+{
+	int i, k, dr, dg, db, dist, best;
+
+	for(i = 0; i < 16; i++)
+	{
+		best = -1;
+
+		for(k = 0; k < 4; k++)
+		{
+			dr = (int)block->r[i] - palette[k][0];
+			dg = (int)block->g[i] - palette[k][1];
+			db = (int)block->b[i] - palette[k][2];
+			dist = dr * dr + dg * dg + db * db;
+
+			if(best < 0 || dist < best)
+			{
+				best		= dist;
+				indices[i]	= k;
+			}
+		}
+	}
+}
+
+/*
+ * dxt_encodeColor
+ * Always 4 colour mode, c0 > c1. If they come out equal every index is 0.
+ */
+static void dxt_encodeColor(const dxtBlock_t *block, byte *out)
+{
+	int				c0, c1, swap, i, palette[4][3], indices[16];
+	unsigned int	bits;
+
+	dxt_fitEndpoints(block, &c0, &c1);
+
+	if(c0 < c1)
+	{
+		swap = c0;
+		c0	 = c1;
+		c1	 = swap;
+	}
+
+	bits = 0;
+
+	if(c0 != c1)
+	{
+		dxt_palette(c0, c1, palette);
+		dxt_indices(block, (const int (*)[3])palette, indices);
+
+		for(i = 0; i < 16; i++)
+			bits |= (unsigned int)indices[i] << (i * 2);
+	}
+
+	out[0] = c0 & 0xff;
+	out[1] = c0 >> 8;
+	out[2] = c1 & 0xff;
+	out[3] = c1 >> 8;
+	out[4] = bits & 0xff;
+	out[5] = (bits >> 8)  & 0xff;
+	out[6] = (bits >> 16) & 0xff;
+	out[7] = bits >> 24;
+}
+
+/*
+ * dxt_alphaPalette
+ * 8 value mode when a0 > a1, which is the only one the encoder uses.
+ */
+static void dxt_alphaPalette(int a0, int a1, int *palette)
+{
+	int k;
+
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if(a0 > a1)
+	{
+		for(k = 2; k < 8; k++)
+			palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+	}
+	else
+	{
+		for(k = 2; k < 6; k++)
+			palette[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+/*
+ * dxt_encodeAlpha
+ */
+static void dxt_encodeAlpha(const dxtBlock_t *block, byte *out)
+{
+	int			a0, a1, i, k, best, dist, index, palette[8];
+	long long	bits;
+
+	a0 = a1 = block->a[0];
+	for(i = 1; i < 16; i++)
+	{
+		if(block->a[i] > a0) a0 = block->a[i];
+		if(block->a[i] < a1) a1 = block->a[i];
+	}
+
+	bits = 0;
+
+	if(a0 != a1)
+	{
+		dxt_alphaPalette(a0, a1, palette);
+
+		for(i = 0; i < 16; i++)
+		{
+			best  = 256;
+			index = 0;
+
+			for(k = 0; k < 8; k++)
+			{
+				dist = abs(block->a[i] - palette[k]);
+				if(dist < best)
+				{
+					best  = dist;
+					index = k;
+				}
+			}
+
+			bits |= (long long)index << (i * 3);
+		}
+	}
+
+	out[0] = a0;
+	out[1] = a1;
+	for(i = 0; i < 6; i++)
+		out[2 + i] = (bits >> (i * 8)) & 0xff;
+}
+
+/*
+ * renderer_img_encodeDXT
+ * Compresses one RGB(A) level, top row first. out needs
+ * renderer_img_dxtSize bytes. BC1 ignores alpha.
+ */
+void renderer_img_encodeDXT(const byte *pixels, int width, int height, int comps, byte *out, int format)
+{
+	dxtBlock_t	block;
+	int			bx, by;
+
+	for(by = 0; by < height; by += 4)
+	{
+		for(bx = 0; bx < width; bx += 4)
+		{
+			dxt_fetchBlock(pixels, width, height, comps, bx, by, &block);
+
+			if(format == DXT_BC3)
+			{
+				dxt_encodeAlpha(&block, out);
+				out += 8;
+			}
+
+			dxt_encodeColor(&block, out);
+			out += 8;
+		}
+	}
+}
+
+/*
+ * renderer_img_decodeDXT
+ * Expands one level back to RGB(A), comps bytes a pixel. A BC1 block with
+ * c0 <= c1 is 3 colour mode, with index 3 transparent black. BC3's colour
+ * blocks are always 4 colour.
+ */
+void renderer_img_decodeDXT(const byte *in, int width, int height, byte *pixels, int comps, int format)
+{
+	int				bx, by, x, y, i, c0, c1, index, palette[4][3], alpha[8], colorAlpha[4];
+	unsigned int	bits;
+	long long		alphaBits;
+	byte			*dst;
+
+	for(by = 0; by < height; by += 4)
+	{
+		for(bx = 0; bx < width; bx += 4)
+		{
+			alphaBits = 0;
+
+			if(format == DXT_BC3)
+			{
+				dxt_alphaPalette(in[0], in[1], alpha);
+
+				for(i = 0; i < 6; i++)
+					alphaBits |= (long long)in[2 + i] << (i * 8);
+
+				in += 8;
+			}
+
+			c0	 = in[0] | (in[1] << 8);
+			c1	 = in[2] | (in[3] << 8);
+			bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+			in	+= 8;
+
+			colorAlpha[0] = colorAlpha[1] = colorAlpha[2] = colorAlpha[3] = 255;
+
+			if(format == DXT_BC3 || c0 > c1)
+				dxt_palette(c0, c1, palette);
+			else
+			{
+				dxt_from565(c0, palette[0]);
+				dxt_from565(c1, palette[1]);
+
+				for(i = 0; i < 3; i++)
+				{
+					palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+					palette[3][i] = 0;
+				}
+
+				colorAlpha[3] = 0;
+			}
+
+			for(y = 0; y < 4 && by + y < height; y++)
+			{
+				dst = pixels + ((by + y) * width + bx) * comps;
+
+				for(x = 0; x < 4 && bx + x < width; x++, dst += comps)
+				{
+					i	  = y * 4 + x;
+					index = (bits >> (i * 2)) & 3;
+
+					dst[0] = palette[index][0];
+					dst[1] = palette[index][1];
+					dst[2] = palette[index][2];
+
+					if(comps == 4)
+						dst[3] = (format == DXT_BC3) ? alpha[(alphaBits >> (i * 3)) & 7] : colorAlpha[index];
+				}
+			}
+		}
+	}
+}
+
+#ifdef SIMD_X86
+
+/*
+ * dxt_indicesSSE2
+ * Four pixels at a time. Same tie breaking as the scalar version: a later
+ * entry only wins if it's strictly closer.
+ */
+SIMD_TARGET("sse2") static void dxt_indicesSSE2(const dxtBlock_t *block, const int palette[4][3], int *indices)
+{
+	__m128	r, g, b, dr, dg, db, dist, best;
+	__m128i	index, mask;
+	int		i, k;
+
+	for(i = 0; i < 16; i += 4)
+	{
+		r = _mm_loadu_ps(block->r + i);
+		g = _mm_loadu_ps(block->g + i);
+		b = _mm_loadu_ps(block->b + i);
+
+		best  = _mm_set1_ps(1e30f);
+		index = _mm_setzero_si128();
+
+		for(k = 0; k < 4; k++)
+		{
+			dr = _mm_sub_ps(r, _mm_set1_ps((float)palette[k][0]));
+			dg = _mm_sub_ps(g, _mm_set1_ps((float)palette[k][1]));
+			db = _mm_sub_ps(b, _mm_set1_ps((float)palette[k][2]));
+
+			dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+			mask = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+
+			best  = _mm_min_ps(dist, best);
+			index = _mm_or_si128(_mm_andnot_si128(mask, index), _mm_and_si128(mask, _mm_set1_epi32(k)));
+		}
+
+		_mm_storeu_si128((__m128i *)(indices + i), index);
+	}
+}
+
+#endif
@@ -0,0 +1,701 @@
+/*
+===========================================================================
+File:		renderer_img_loader.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Background texture loading. The GL thread hands out a texture
+			name straight away (display lists bind it when a model loads)
+			and a worker thread reads the file and builds the mips. All the
+			GL thread does later is copy the levels into the texture.
+			If the file can't be read the name is given back, and the
+			lists that bound it have to be recompiled.
+
+			With persistent mapping and pixel buffer objects the workers
+			write the levels into one mapped staging buffer, used as a
+			ring. Space is handed out in order and given back in the same
+			order once the fence after its upload has signalled, so the
+			ring is just a head and a count of bytes in use. A worker that
+			finds it full waits. Without them, or for an image bigger than
+			the whole ring, the GL thread uploads from the worker's copy in
+			client memory, which still takes the decode off the GL thread.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+#include "headers/SDL/SDL_thread.h"
+#include "headers/SDL/SDL_mutex.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_materials.h"
+
+//Staging space handed out is rounded up to this
+#define STAGING_ALIGN 64
+
+//How long to wait on a fence before asking again, in nanoseconds
+#define FENCE_TIMEOUT 1000000
+
+typedef enum { JOB_FREE, JOB_QUEUED, JOB_DECODING, JOB_READY, JOB_FENCED } loadJobState_t;
+
+typedef struct
+{
+	char			name[MAX_FILEPATH];
+	int				glTexID;
+	loadJobState_t	state;
+
+	//Levels above firstLevel are left out, for streamed textures
+	texture_t		*texture;
+	int				firstLevel;
+
+	//Cancelled jobs are still seen through, they just never get uploaded
+	eboolean		cancelled, failed;
+
+	//Set if the name was generated for this job rather than being the
+	//texture's from an earlier load, so it's ours to give back on failure
+	eboolean		ownsName;
+
+	//With staged set the level pointers are offsets into the staging
+	//buffer, stagingBytes of which (padding included) belong to this job
+	//until its fence signals
+	image_t			image;
+	eboolean		staged;
+	int				stagingBytes;
+	GLsync			fence;
+
+	//Of the pixels, taken before they're staged
+	unsigned int	hash;
+}
+loadJob_t;
+
+//First in, first out, of indices into jobs
+typedef struct
+{
+	int items[MAX_TEXTURES];
+	int first, count;
+}
+jobQueue_t;
+
+static loadJob_t	jobs[MAX_TEXTURES];
+static int			pendingJobs = 0;
+
+//Waiting to be decoded, waiting to be uploaded, and holding staging space
+//in the order it was handed out
+static jobQueue_t	queued, ready, staged;
+
+static SDL_Thread	*threads[MAX_LOADER_THREADS];
+static int			numThreads = 0;
+static eboolean		quit = efalse;
+
+//Everything above and the staging ring are only touched with lock held.
+//workCond is for jobs being queued, readyCond for them being decoded,
+//stagingCond for staging space being given back.
+static SDL_mutex	*lock = NULL;
+static SDL_cond		*workCond = NULL, *readyCond = NULL, *stagingCond = NULL;
+
+static GLuint		pbo = 0;
+static byte			*stagingMapped = NULL;
+static int			stagingHead = 0, stagingUsed = 0;
+
+static int			stagedLoads = 0, clientLoads = 0, stagingWaits = 0;
+
+static int loader_thread(void *threadNum);
+
+/*
+ * loader_push
+ */
+static void loader_push(jobQueue_t *queue, int job)
+{
+	queue->items[(queue->first + queue->count) % MAX_TEXTURES] = job;
+	queue->count++;
+}
+
+/*
+ * loader_pop
+ */
+static int loader_pop(jobQueue_t *queue)
+{
+	int job;
+
+	job = queue->items[queue->first];
+	queue->first = (queue->first + 1) % MAX_TEXTURES;
+	queue->count--;
+
+	return job;
+}
+
+/*
+ * renderer_img_initLoader
+ * Call after renderer_glext_init. With no threads, nothing is queued and
+ * every texture loads on the GL thread the way it always did.
+ */
+void renderer_img_initLoader(int threadCount)
+{
+	int i;
+
+	memset(jobs, 0, sizeof(jobs));
+	memset(&queued, 0, sizeof(queued));
+	memset(&ready, 0, sizeof(ready));
+	memset(&staged, 0, sizeof(staged));
+
+	pendingJobs	= 0;
+	quit		= efalse;
+	stagingHead	= 0;
+	stagingUsed	= 0;
+
+	stagedLoads	 = 0;
+	clientLoads	 = 0;
+	stagingWaits = 0;
+
+	if(threadCount <= 0)
+	{
+		printf("Texture loader: off, textures load on the GL thread\n");
+		return;
+	}
+
+	numThreads = threadCount < MAX_LOADER_THREADS ? threadCount : MAX_LOADER_THREADS;
+
+	if(glConfig.persistentMapping && glConfig.pixelBufferObject)
+	{
+		qglGenBuffers(1, &pbo);
+		qglBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+
+		qglBufferStorage(GL_PIXEL_UNPACK_BUFFER, LOADER_STAGING_BYTES, NULL,
+				GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+		stagingMapped = (byte *)qglMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, LOADER_STAGING_BYTES,
+				GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+		qglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		if(stagingMapped == NULL)
+		{
+			qglDeleteBuffers(1, &pbo);
+			pbo = 0;
+		}
+	}
+
+	lock		= SDL_CreateMutex();
+	workCond	= SDL_CreateCond();
+	readyCond	= SDL_CreateCond();
+	stagingCond	= SDL_CreateCond();
+
+	for(i = 0; i < numThreads; i++)
+		threads[i] = SDL_CreateThread(loader_thread, (void *)(size_t)i);
+
+	if(stagingMapped != NULL)
+		printf("Texture loader: %d threads, %d MB staging buffer\n", numThreads, LOADER_STAGING_BYTES / (1024 * 1024));
+	else
+		printf("Texture loader: %d threads, uploading from client memory\n", numThreads);
+}
+
+/*
+ * renderer_img_shutdownLoader
+ * Anything still queued is dropped. Call after the textures have been
+ * released.
+ */
+void renderer_img_shutdownLoader()
+{
+	loadJob_t	*job;
+	int			i;
+
+	if(!numThreads)
+		return;
+
+	SDL_mutexP(lock);
+	quit = etrue;
+	SDL_CondBroadcast(workCond);
+	SDL_CondBroadcast(stagingCond);
+	SDL_mutexV(lock);
+
+	for(i = 0; i < numThreads; i++)
+		SDL_WaitThread(threads[i], NULL);
+
+	for(i = 0; i < MAX_TEXTURES; i++)
+	{
+		job = &jobs[i];
+
+		if(job->fence != NULL)
+		{
+			while(qglClientWaitSync(job->fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT) == GL_TIMEOUT_EXPIRED)
+				;
+			qglDeleteSync(job->fence);
+		}
+
+		if(job->state != JOB_FREE && !job->staged && job->image.data != NULL)
+			renderer_img_freeImage(&job->image);
+	}
+
+	//Deleting a buffer unmaps it
+	if(pbo)
+		qglDeleteBuffers(1, &pbo);
+
+	SDL_DestroyCond(stagingCond);
+	SDL_DestroyCond(readyCond);
+	SDL_DestroyCond(workCond);
+	SDL_DestroyMutex(lock);
+
+	printf("Texture loader: %d textures through the staging buffer, %d from client memory, "
+			"waited for staging space %d times\n", stagedLoads, clientLoads, stagingWaits);
+
+	memset(jobs, 0, sizeof(jobs));
+
+	pbo			  = 0;
+	stagingMapped = NULL;
+	numThreads	  = 0;
+	pendingJobs	  = 0;
+}
+
+/*
+ * renderer_img_queueTGA
+ * Gives the texture a GL name now, unless it has one already, and queues
+ * the file to be loaded into it from firstLevel down. The texture's size
+ * has to be filled in already, from renderer_img_peekTGA. The texture is
+ * written to when the upload happens, so it has to stay put until then or
+ * until the load is cancelled. Returns efalse if it has to be loaded on
+ * the spot instead.
+ */
+eboolean renderer_img_queueTGA(char *name, texture_t *texture, int firstLevel)
+{
+	loadJob_t	*job;
+	int			i;
+
+	if(!numThreads || strlen(name) >= MAX_FILEPATH)
+		return efalse;
+
+	SDL_mutexP(lock);
+
+	for(i = 0; i < MAX_TEXTURES; i++)
+		if(jobs[i].state == JOB_FREE)
+			break;
+
+	if(i == MAX_TEXTURES)
+	{
+		SDL_mutexV(lock);
+		return efalse;
+	}
+
+	job = &jobs[i];
+	memset(job, 0, sizeof(*job));
+
+	strcpy(job->name, name);
+
+	if(texture->glTexID)
+		job->glTexID = texture->glTexID;
+	else
+	{
+		glGenTextures(1, (GLuint *)&job->glTexID);
+		job->ownsName = etrue;
+	}
+
+	job->texture	= texture;
+	job->firstLevel	= firstLevel;
+	job->state		= JOB_QUEUED;
+
+	texture->glTexID = job->glTexID;
+	texture->atlased = efalse;
+
+	loader_push(&queued, i);
+	pendingJobs++;
+
+	SDL_CondSignal(workCond);
+	SDL_mutexV(lock);
+
+	return etrue;
+}
+
+/*
+ * renderer_img_cancelLoad
+ * Makes sure a texture that's being deleted is never uploaded to. The
+ * name can be handed out again straight after, so only jobs that haven't
+ * been uploaded yet are looked at.
+ */
+void renderer_img_cancelLoad(int glTexID)
+{
+	int i;
+
+	if(!numThreads)
+		return;
+
+	SDL_mutexP(lock);
+
+	for(i = 0; i < MAX_TEXTURES; i++)
+	{
+		if(jobs[i].glTexID == glTexID && !jobs[i].cancelled &&
+		   (jobs[i].state == JOB_QUEUED || jobs[i].state == JOB_DECODING || jobs[i].state == JOB_READY))
+		{
+			jobs[i].cancelled = etrue;
+			break;
+		}
+	}
+
+	SDL_mutexV(lock);
+}
+
+/*
+ * loader_levelsSize
+ */
+static int loader_levelsSize(const image_t *image, int firstLevel)
+{
+	int i, width, height, size;
+
+	width  = image->width;
+	height = image->height;
+
+	for(i = 0, size = 0; i < image->numLevels; i++)
+	{
+		if(i >= firstLevel)
+			size += width * height * (image->bpp / 8);
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size;
+}
+
+/*
+ * loader_stage
+ * Copies every level of a decoded image into the staging buffer, top row
+ * first, and frees it. Called with lock held, which is let go of while
+ * waiting for space and while copying. Returns efalse, with the image
+ * untouched, if it has to go from client memory.
+ */
+static eboolean loader_stage(loadJob_t *job, image_t *image)
+{
+	int		size, pad, start, offset, i, y, width, height, rowSize;
+	byte	*src, *dst;
+
+	size = (loader_levelsSize(image, job->firstLevel) + STAGING_ALIGN - 1) & ~(STAGING_ALIGN - 1);
+
+	if(stagingMapped == NULL || size > LOADER_STAGING_BYTES)
+		return efalse;
+
+	//Space that won't fit before the end wraps back to the start, and the
+	//bytes skipped over are given back along with it
+	for(;;)
+	{
+		if(stagingUsed == 0)
+			stagingHead = 0;
+
+		if(stagingHead + size > LOADER_STAGING_BYTES)
+		{
+			pad	  = LOADER_STAGING_BYTES - stagingHead;
+			start = 0;
+		}
+		else
+		{
+			pad	  = 0;
+			start = stagingHead;
+		}
+
+		if(stagingUsed + pad + size <= LOADER_STAGING_BYTES)
+			break;
+
+		if(quit)
+			return efalse;
+
+		stagingWaits++;
+		SDL_CondWait(stagingCond, lock);
+	}
+
+	stagingHead		  = start + size;
+	stagingUsed		 += pad + size;
+	job->stagingBytes = pad + size;
+	job->staged		  = etrue;
+
+	loader_push(&staged, job - jobs);
+
+	SDL_mutexV(lock);
+
+	job->image			 = *image;
+	job->image.flags	&= ~IMAGE_BOTTOM_UP;
+	job->image.data		 = NULL;
+	job->image.block	 = NULL;
+
+	width	= image->width;
+	height	= image->height;
+	offset	= start;
+
+	for(i = 0; i < image->numLevels; i++)
+	{
+		rowSize = width * (image->bpp / 8);
+		src		= image->levels[i];
+		dst		= stagingMapped + offset;
+
+		if(i < job->firstLevel)
+		{
+			job->image.levels[i] = NULL;
+
+			width  = width  > 1 ? width  / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			continue;
+		}
+
+		if(image->flags & IMAGE_BOTTOM_UP)
+		{
+			for(y = 0; y < height; y++)
+				memcpy(dst + (height - 1 - y) * rowSize, src + y * rowSize, rowSize);
+		}
+		else
+			memcpy(dst, src, rowSize * height);
+
+		job->image.levels[i] = (byte *)(size_t)offset;
+		offset += rowSize * height;
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	renderer_img_freeImage(image);
+
+	SDL_mutexP(lock);
+	return etrue;
+}
+
+/*
+ * loader_thread
+ */
+static int loader_thread(void *threadNum)
+{
+	loadJob_t	*job;
+	image_t		image;
+	eboolean	loaded;
+
+	SDL_mutexP(lock);
+
+	for(;;)
+	{
+		while(!quit && !queued.count)
+			SDL_CondWait(workCond, lock);
+
+		if(quit)
+			break;
+
+		job = &jobs[loader_pop(&queued)];
+
+		if(!job->cancelled)
+		{
+			job->state = JOB_DECODING;
+			SDL_mutexV(lock);
+
+			//Same as renderer_img_loadTGA from here
+			loaded = renderer_img_readTGA(job->name, &image, glConfig.bgra);
+			if(loaded)
+			{
+				renderer_img_applyQuality(&image);
+				job->hash = renderer_img_hashImage(&image);
+				renderer_img_buildMips(&image);
+			}
+			else
+				printf("Texture loader: thread %d couldn't load %s\n", (int)(size_t)threadNum, job->name);
+
+			SDL_mutexP(lock);
+
+			if(loaded && !loader_stage(job, &image))
+				job->image = image;
+
+			job->failed = !loaded;
+		}
+
+		job->state = JOB_READY;
+		loader_push(&ready, job - jobs);
+		SDL_CondSignal(readyCond);
+	}
+
+	SDL_mutexV(lock);
+	return 0;
+}
+
+/*
+ * loader_freeJob
+ */
+static void loader_freeJob(loadJob_t *job)
+{
+	job->state = JOB_FREE;
+	pendingJobs--;
+}
+
+/*
+ * loader_reclaim
+ * Gives back staging space whose uploads the GPU is done with, waiting
+ * for the oldest of them if told to. Called with lock held. Returns
+ * etrue if anything was given back.
+ */
+static eboolean loader_reclaim(eboolean wait)
+{
+	loadJob_t	*job;
+	GLenum		result;
+	eboolean	reclaimed;
+
+	reclaimed = efalse;
+
+	while(staged.count)
+	{
+		job = &jobs[staged.items[staged.first]];
+
+		if(job->state != JOB_FENCED)
+			break;
+
+		if(job->fence != NULL)
+		{
+			result = qglClientWaitSync(job->fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FENCE_TIMEOUT : 0);
+
+			if(result == GL_TIMEOUT_EXPIRED)
+			{
+				if(!wait)
+					break;
+				continue;
+			}
+
+			qglDeleteSync(job->fence);
+			job->fence = NULL;
+		}
+
+		stagingUsed -= job->stagingBytes;
+		loader_pop(&staged);
+		loader_freeJob(job);
+
+		reclaimed = etrue;
+		wait	  = efalse;
+	}
+
+	if(reclaimed)
+		SDL_CondBroadcast(stagingCond);
+
+	return reclaimed;
+}
+
+/*
+ * loader_upload
+ * A decoded job's levels, into the texture it was queued for.
+ */
+static void loader_upload(loadJob_t *job)
+{
+	glBindTexture(GL_TEXTURE_2D, job->glTexID);
+	renderer_img_texParams(job->image.numLevels);
+
+	if(job->staged)
+	{
+		qglBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		renderer_img_uploadLevels(&job->image, job->firstLevel);
+		qglBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		job->fence = qglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		stagedLoads++;
+	}
+	else
+	{
+		renderer_img_uploadLevels(&job->image, job->firstLevel);
+		clientLoads++;
+	}
+
+	//Anything finer than what was sent is either still there from before
+	//or never has been
+	if(job->texture->streamed)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job->firstLevel);
+
+	job->texture->numLevels	= job->image.numLevels;
+	job->texture->baseLevel	= job->firstLevel;
+	job->texture->format	= renderer_img_imageFormat(&job->image);
+	job->texture->hash		= job->hash;
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/*
+ * loader_fail
+ * A texture that got its name from a load that failed gets no texture at
+ * all, the same as if it had been loaded on the spot. One that already
+ * had levels keeps them, and isn't streamed any further.
+ */
+static void loader_fail(loadJob_t *job)
+{
+	if(job->ownsName)
+	{
+		glDeleteTextures(1, (GLuint *)&job->glTexID);
+
+		job->texture->glTexID	= 0;
+		job->texture->numLevels	= 1;
+		job->texture->baseLevel	= 0;
+	}
+
+	job->texture->streamed = efalse;
+}
+
+/*
+ * renderer_img_updateLoads
+ * Uploads everything that has finished decoding. Call once a frame, from
+ * the GL thread. Returns etrue if a failed load took a texture's name
+ * away, see renderer_model_refreshTextures.
+ */
+eboolean renderer_img_updateLoads()
+{
+	loadJob_t	*job;
+	eboolean	 lostNames = efalse;
+
+	if(!numThreads)
+		return efalse;
+
+	SDL_mutexP(lock);
+	loader_reclaim(efalse);
+
+	while(ready.count)
+	{
+		job = &jobs[loader_pop(&ready)];
+
+		SDL_mutexV(lock);
+
+		if(!job->cancelled && !job->failed)
+			loader_upload(job);
+		else if(!job->cancelled)
+		{
+			lostNames |= job->ownsName;
+			loader_fail(job);
+		}
+
+		if(!job->staged && job->image.data != NULL)
+			renderer_img_freeImage(&job->image);
+
+		SDL_mutexP(lock);
+
+		//Staging space is held on to until the fence says the copy is done
+		if(job->staged)
+			job->state = JOB_FENCED;
+		else
+			loader_freeJob(job);
+	}
+
+	SDL_mutexV(lock);
+	return lostNames;
+}
+
+/*
+ * renderer_img_flushLoads
+ * Waits until everything queued so far has been uploaded. Returns the
+ * same as renderer_img_updateLoads.
+ */
+eboolean renderer_img_flushLoads()
+{
+	eboolean lostNames = efalse;
+
+	if(!numThreads)
+		return efalse;
+
+	SDL_mutexP(lock);
+
+	while(pendingJobs > 0)
+	{
+		if(!ready.count && !loader_reclaim(etrue))
+			SDL_CondWait(readyCond, lock);
+
+		SDL_mutexV(lock);
+		lostNames |= renderer_img_updateLoads();
+		SDL_mutexP(lock);
+	}
+
+	SDL_mutexV(lock);
+	return lostNames;
+}
@@ -0,0 +1,378 @@
+/*
+===========================================================================
+File:		renderer_img_mips.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Mip chain generation on the CPU. Pixels are averaged in linear
+			light rather than straight on the sRGB bytes, otherwise every
+			level comes out darker than the last. Each level is built from
+			the previous level's float copy, so rounding never stacks up.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_cpuinfo.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+#include "headers/simd.h"
+
+#include "headers/renderer_materials.h"
+
+#ifdef SIMD_X86
+#include <emmintrin.h>
+#endif
+
+#include <math.h>
+
+//Resolution of the linear to sRGB table
+#define LINEAR_STEPS 4096
+
+typedef void (*mipDownsampleFunc_t)(const float *src, int srcWidth, int srcHeight,
+		float *dst, int dstWidth, int dstHeight);
+typedef void (*mipEncodeFunc_t)(const float *src, byte *dst, int numPixels, int comps);
+
+static void mips_downsampleScalar(const float *src, int srcWidth, int srcHeight,
+		float *dst, int dstWidth, int dstHeight);
+static void mips_encodeScalar(const float *src, byte *dst, int numPixels, int comps);
+
+#ifdef SIMD_X86
+static void mips_downsampleSSE(const float *src, int srcWidth, int srcHeight,
+		float *dst, int dstWidth, int dstHeight);
+static void mips_encodeSSE(const float *src, byte *dst, int numPixels, int comps);
+#endif
+
+static float	srgbToLinear[256];
+static byte		linearToSrgb[LINEAR_STEPS + 1];
+
+static mipDownsampleFunc_t	mips_downsample = mips_downsampleScalar;
+static mipEncodeFunc_t		mips_encode		= mips_encodeScalar;
+
+/*
+ * renderer_img_initMips
+ * Builds the gamma tables and picks the vector or scalar code paths. Both
+ * give the same bytes. Call once before any renderer_img_buildMips.
+ */
+void renderer_img_initMips()
+{
+	int		i;
+	float	c;
+
+	for(i = 0; i < 256; i++)
+	{
+		c = i / 255.0;
+		srgbToLinear[i] = (c <= 0.04045) ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+	}
+
+	for(i = 0; i <= LINEAR_STEPS; i++)
+	{
+		c = (float)i / LINEAR_STEPS;
+		c = (c <= 0.0031308) ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+		linearToSrgb[i] = (byte)(c * 255.0 + 0.5);
+	}
+
+#ifdef SIMD_X86
+	if(SDL_HasSSE2())
+	{
+		mips_downsample = mips_downsampleSSE;
+		mips_encode		= mips_encodeSSE;
+	}
+#endif
+}
+
+/*
+ * mips_decode
+ * Expands a level to linear RGBA floats. Alpha isn't gamma encoded.
+ */
+static void mips_decode(const byte *src, float *dst, int numPixels, int comps)
+{
+	int i;
+
+	for(i = 0; i < numPixels; i++, src += comps, dst += 4)
+	{
+		dst[0] = srgbToLinear[src[0]];
+		dst[1] = srgbToLinear[src[1]];
+		dst[2] = srgbToLinear[src[2]];
+		dst[3] = (comps == 4) ? src[3] / 255.0 : 1.0;
+	}
+}
+
+/*
+ * mips_downsampleScalar
+ * 2x2 box filter. On odd sizes the last row/column is reused rather than
+ * read past the edge.
+ */
+static void mips_downsampleScalar(const float *src, int srcWidth, int srcHeight,
+		float *dst, int dstWidth, int dstHeight)
+{
+	int			x, y, c, x0, x1;
+	const float	*row0, *row1;
+
+	for(y = 0; y < dstHeight; y++)
+	{
+		row0 = src + (y * 2) * srcWidth * 4;
+		row1 = (y * 2 + 1 < srcHeight) ? row0 + srcWidth * 4 : row0;
+
+		for(x = 0; x < dstWidth; x++, dst += 4)
+		{
+			x0 = x * 2 * 4;
+			x1 = (x * 2 + 1 < srcWidth) ? x0 + 4 : x0;
+
+			for(c = 0; c < 4; c++)
+				dst[c] = ((row0[x0 + c] + row0[x1 + c]) + (row1[x0 + c] + row1[x1 + c])) * 0.25f;
+		}
+	}
+}
+
+/*
+ * mips_encodeScalar
+ */
+static void mips_encodeScalar(const float *src, byte *dst, int numPixels, int comps)
+{
+	int i, c;
+
+	for(i = 0; i < numPixels; i++, src += 4, dst += comps)
+	{
+		for(c = 0; c < 3; c++)
+			dst[c] = linearToSrgb[(int)(src[c] * LINEAR_STEPS + 0.5f)];
+
+		if(comps == 4)
+			dst[3] = (byte)(int)(src[3] * 255.0f + 0.5f);
+	}
+}
+
+#ifdef SIMD_X86
+
+/*
+ * mips_downsampleSSE
+ * One RGBA pixel per register, same sums in the same order as the scalar
+ * version.
+ */
+SIMD_TARGET("sse2") static void mips_downsampleSSE(const float *src, int srcWidth, int srcHeight,
+		float *dst, int dstWidth, int dstHeight)
+{
+	int			x, y, x0, x1;
+	const float	*row0, *row1;
+	__m128		quarter, a, b;
+
+	quarter = _mm_set1_ps(0.25f);
+
+	for(y = 0; y < dstHeight; y++)
+	{
+		row0 = src + (y * 2) * srcWidth * 4;
+		row1 = (y * 2 + 1 < srcHeight) ? row0 + srcWidth * 4 : row0;
+
+		for(x = 0; x < dstWidth; x++, dst += 4)
+		{
+			x0 = x * 2 * 4;
+			x1 = (x * 2 + 1 < srcWidth) ? x0 + 4 : x0;
+
+			a = _mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1));
+			b = _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1));
+
+			_mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(a, b), quarter));
+		}
+	}
+}
+
+/*
+ * mips_encodeSSE
+ * Scales and rounds a whole pixel at once, the table lookups stay scalar.
+ */
+SIMD_TARGET("sse2") static void mips_encodeSSE(const float *src, byte *dst, int numPixels, int comps)
+{
+	int		i, idx[4];
+	__m128	scale, half;
+
+	scale = _mm_setr_ps(LINEAR_STEPS, LINEAR_STEPS, LINEAR_STEPS, 255.0f);
+	half  = _mm_set1_ps(0.5f);
+
+	for(i = 0; i < numPixels; i++, src += 4, dst += comps)
+	{
+		//Truncating convert, to match the scalar (int) casts
+		_mm_storeu_si128((__m128i *)idx,
+				_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src), scale), half)));
+
+		dst[0] = linearToSrgb[idx[0]];
+		dst[1] = linearToSrgb[idx[1]];
+		dst[2] = linearToSrgb[idx[2]];
+
+		if(comps == 4)
+			dst[3] = (byte)idx[3];
+	}
+}
+
+#endif
+
+/*
+ * mips_alloc
+ * width x height pixels of pixelSize bytes each, or NULL if that many
+ * bytes can't be had, or can't even be asked for in a size_t.
+ */
+static void * mips_alloc(int width, int height, int pixelSize)
+{
+	Uint64 size = (Uint64)width * height * pixelSize;
+
+	if(size > (size_t)-1)
+		return NULL;
+
+	return malloc((size_t)size);
+}
+
+/*
+ * renderer_img_buildMips
+ * Fills in every level below the base image, down to 1x1. Does nothing if
+ * the chain is already there (e.g. it came out of a cooked file).
+ * Bottom up images are filtered top row first, same as any other, so odd
+ * heights pair up the same rows. If memory runs out the chain stops at the
+ * levels built so far, which GL takes as long as MAX_LEVEL says so.
+ */
+void renderer_img_buildMips(image_t *image)
+{
+	int			comps, width, height, nextWidth, nextHeight, y;
+	float		*linear, *next;
+	eboolean	bottomUp;
+
+	if(image->numLevels > 1 || image->data == NULL)
+		return;
+
+	comps	 = image->bpp / 8;
+	width	 = image->width;
+	height	 = image->height;
+	bottomUp = (image->flags & IMAGE_BOTTOM_UP) ? etrue : efalse;
+
+	linear = (float *)mips_alloc(width, height, sizeof(float) * 4);
+
+	if(linear == NULL)
+	{
+		printf("Mips: out of memory for %dx%d, no mips built.\n", width, height);
+		return;
+	}
+
+	if(bottomUp)
+	{
+		for(y = 0; y < height; y++)
+			mips_decode(image->data + (height - 1 - y) * width * comps, linear + y * width * 4, width, comps);
+	}
+	else
+		mips_decode(image->data, linear, width * height, comps);
+
+	while((width > 1 || height > 1) && image->numLevels < MAX_IMAGE_LEVELS)
+	{
+		nextWidth  = width  > 1 ? width  / 2 : 1;
+		nextHeight = height > 1 ? height / 2 : 1;
+
+		next = (float *)mips_alloc(nextWidth, nextHeight, sizeof(float) * 4);
+		image->levels[image->numLevels] = (byte *)mips_alloc(nextWidth, nextHeight, comps);
+
+		if(next == NULL || image->levels[image->numLevels] == NULL)
+		{
+			printf("Mips: out of memory for %dx%d, stopping at %d levels.\n",
+					nextWidth, nextHeight, image->numLevels);
+
+			free(image->levels[image->numLevels]);
+			image->levels[image->numLevels] = NULL;
+			free(next);
+			break;
+		}
+
+		mips_downsample(linear, width, height, next, nextWidth, nextHeight);
+
+		if(bottomUp)
+		{
+			for(y = 0; y < nextHeight; y++)
+				mips_encode(next + y * nextWidth * 4, image->levels[image->numLevels] +
+						(nextHeight - 1 - y) * nextWidth * comps, nextWidth, comps);
+		}
+		else
+			mips_encode(next, image->levels[image->numLevels], nextWidth * nextHeight, comps);
+		image->numLevels++;
+
+		free(linear);
+		linear = next;
+		width  = nextWidth;
+		height = nextHeight;
+	}
+
+	free(linear);
+}
+
+/*
+ * renderer_img_shrinkImage
+ * Halves the base image steps times, the same way the mip chain is built,
+ * so it comes out exactly as that level would have. Only for an image
+ * without its mip chain yet. It ends up top row first in new memory of its
+ * own, whatever it was before. If memory runs out it stops at the last
+ * size it got to, or is left alone if it didn't get that far.
+ */
+void renderer_img_shrinkImage(image_t *image, int steps)
+{
+	int		comps, width, height, nextWidth, nextHeight, y;
+	float	*linear, *next;
+	byte	*data;
+
+	if(steps <= 0 || image->numLevels > 1 || image->data == NULL)
+		return;
+
+	comps  = image->bpp / 8;
+	width  = image->width;
+	height = image->height;
+
+	linear = (float *)mips_alloc(width, height, sizeof(float) * 4);
+
+	if(linear == NULL)
+	{
+		printf("Mips: out of memory for %dx%d, not shrunk.\n", width, height);
+		return;
+	}
+
+	if(image->flags & IMAGE_BOTTOM_UP)
+	{
+		for(y = 0; y < height; y++)
+			mips_decode(image->data + (height - 1 - y) * width * comps, linear + y * width * 4, width, comps);
+	}
+	else
+		mips_decode(image->data, linear, width * height, comps);
+
+	for(; steps > 0 && (width > 1 || height > 1); steps--)
+	{
+		nextWidth  = width  > 1 ? width  / 2 : 1;
+		nextHeight = height > 1 ? height / 2 : 1;
+
+		next = (float *)mips_alloc(nextWidth, nextHeight, sizeof(float) * 4);
+
+		if(next == NULL)
+		{
+			printf("Mips: out of memory for %dx%d, shrunk to %dx%d.\n", nextWidth, nextHeight, width, height);
+			break;
+		}
+
+		mips_downsample(linear, width, height, next, nextWidth, nextHeight);
+
+		free(linear);
+		linear = next;
+		width  = nextWidth;
+		height = nextHeight;
+	}
+
+	data = (byte *)mips_alloc(width, height, comps);
+
+	if(data == NULL)
+	{
+		printf("Mips: out of memory for %dx%d, not shrunk.\n", width, height);
+		free(linear);
+		return;
+	}
+
+	mips_encode(linear, data, width * height, comps);
+	free(linear);
+
+	renderer_img_freeImage(image);
+
+	image->width	 = width;
+	image->height	 = height;
+	image->flags	&= ~(IMAGE_BOTTOM_UP | IMAGE_MAPPED);
+	image->data		 = data;
+	image->numLevels = 1;
+	image->levels[0] = data;
+}
@@ -0,0 +1,144 @@
+/*
+===========================================================================
+File:		renderer_img_quality.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Texture quality presets. Below full quality every texture
+			loses its finest levels before it's uploaded, and so does any
+			texture still bigger than the size cap. Decoded images are
+			shrunk the same way their mips are built, cooked ones just
+			skip the levels they already have.
+
+			Memory is counted as uploaded, mip chains included, both as it
+			would have been at full quality and as it is.
+===========================================================================
+*/
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_materials.h"
+
+static const char *qualityNames[] = { "full", "half", "quarter" };
+
+static int	quality = TEXTURE_QUALITY_FULL;
+static int	maxSize = TEXTURE_MAX_SIZE;
+
+//Written to from the loader threads
+static int	fullBytes = 0, keptBytes = 0, shrunkTextures = 0;
+
+/*
+ * renderer_img_setQuality
+ * Applies to textures loaded from here on. A size of 0 is no cap.
+ */
+void renderer_img_setQuality(int newQuality, int newMaxSize)
+{
+	if(newQuality < TEXTURE_QUALITY_FULL)
+		newQuality = TEXTURE_QUALITY_FULL;
+	if(newQuality > TEXTURE_QUALITY_QUARTER)
+		newQuality = TEXTURE_QUALITY_QUARTER;
+
+	quality = newQuality;
+	maxSize = newMaxSize > 0 ? newMaxSize : 0;
+}
+
+/*
+ * renderer_img_qualityByName
+ * "full", "half" or "quarter", -1 for anything else.
+ */
+int renderer_img_qualityByName(const char *name)
+{
+	int i;
+
+	for(i = TEXTURE_QUALITY_FULL; i <= TEXTURE_QUALITY_QUARTER; i++)
+		if(!strcmp(name, qualityNames[i]))
+			return i;
+
+	return -1;
+}
+
+/*
+ * renderer_img_qualityLevels
+ * How many levels a texture of this size loses, and its size after.
+ * Never takes it below 1x1.
+ */
+int renderer_img_qualityLevels(int *width, int *height)
+{
+	int levels;
+
+	for(levels = 0; *width > 1 || *height > 1; levels++)
+	{
+		if(levels >= quality && (!maxSize || (*width <= maxSize && *height <= maxSize)))
+			break;
+
+		*width	= *width  > 1 ? *width  / 2 : 1;
+		*height	= *height > 1 ? *height / 2 : 1;
+	}
+
+	return levels;
+}
+
+/*
+ * quality_chainBytes
+ * A full mip chain, uncompressed.
+ */
+static int quality_chainBytes(int width, int height, int comps)
+{
+	int bytes;
+
+	for(bytes = width * height * comps; width > 1 || height > 1; bytes += width * height * comps)
+	{
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return bytes;
+}
+
+/*
+ * renderer_img_applyQuality
+ * Shrinks a decoded image, before its mips are built. Safe to call from
+ * any thread.
+ */
+void renderer_img_applyQuality(image_t *image)
+{
+	int width, height, levels, before;
+
+	width  = image->width;
+	height = image->height;
+	levels = renderer_img_qualityLevels(&width, &height);
+	before = quality_chainBytes(image->width, image->height, image->bpp / 8);
+
+	if(levels > 0)
+		renderer_img_shrinkImage(image, levels);
+
+	renderer_img_countQuality(before, quality_chainBytes(image->width, image->height, image->bpp / 8));
+}
+
+/*
+ * renderer_img_countQuality
+ * For textures that got to their size some other way.
+ */
+void renderer_img_countQuality(int full, int kept)
+{
+	__sync_fetch_and_add(&fullBytes, full);
+	__sync_fetch_and_add(&keptBytes, kept);
+
+	if(kept < full)
+		__sync_fetch_and_add(&shrunkTextures, 1);
+}
+
+/*
+ * renderer_img_reportQuality
+ */
+void renderer_img_reportQuality()
+{
+	printf("Texture quality: %s", qualityNames[quality]);
+
+	if(maxSize)
+		printf(", at most %dx%d", maxSize, maxSize);
+
+	printf(". %d textures shrunk, %d KB before, %d KB after\n",
+			shrunkTextures, fullBytes / 1024, keptBytes / 1024);
+}
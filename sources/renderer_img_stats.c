@@ -0,0 +1,454 @@
+/*
+===========================================================================
+File:		renderer_img_stats.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Texture memory accounting. Everything is worked out from the
+			texture cache when it's asked for, nothing is kept up to date
+			as textures come and go. Sizes are what GL was given: RGB is 3
+			bytes a pixel even though most drivers pad it to 4.
+
+			Duplicates are found by a hash of each texture's pixels, taken
+			when it was loaded. Decoded images are hashed as RGB(A), top
+			row first, whatever order they were read in, so the same
+			picture saved two different ways still matches. Cooked ones
+			are hashed as their blocks, and only match other cooked ones.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_materials.h"
+#include "headers/renderer_models.h"
+
+#define FNV_OFFSET	2166136261u
+#define FNV_PRIME	16777619u
+
+/*
+ * renderer_img_hashBytes
+ * FNV-1a
+ */
+unsigned int renderer_img_hashBytes(const byte *data, int size)
+{
+	unsigned int	hash = FNV_OFFSET;
+	int				i;
+
+	for(i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/*
+ * renderer_img_hashImage
+ * FNV-1a of the size and the base level's pixels, in the same order
+ * whatever the image's layout flags are. Never 0, that's for no hash.
+ */
+unsigned int renderer_img_hashImage(const image_t *image)
+{
+	unsigned int	hash;
+	int				comps, x, y, row, c, order[4];
+	const byte		*pixel;
+
+	comps = image->bpp / 8;
+
+	for(c = 0; c < 4; c++)
+		order[c] = c;
+
+	if(image->flags & IMAGE_BGR)
+	{
+		order[0] = 2;
+		order[2] = 0;
+	}
+
+	hash = (FNV_OFFSET ^ image->width) * FNV_PRIME;
+	hash = (hash ^ image->height) * FNV_PRIME;
+
+	for(y = 0; y < image->height; y++)
+	{
+		row	  = (image->flags & IMAGE_BOTTOM_UP) ? image->height - 1 - y : y;
+		pixel = image->data + row * image->width * comps;
+
+		for(x = 0; x < image->width; x++, pixel += comps)
+		{
+			for(c = 0; c < comps; c++)
+			{
+				hash ^= pixel[order[c]];
+				hash *= FNV_PRIME;
+			}
+		}
+	}
+
+	return hash ? hash : 1;
+}
+
+/*
+ * renderer_img_formatBytes
+ * One level of a texture with the given GL internal format.
+ */
+int renderer_img_formatBytes(int format, int width, int height)
+{
+	switch(format)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			return renderer_img_dxtSize(width, height, DXT_BC1);
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return renderer_img_dxtSize(width, height, DXT_BC3);
+		case GL_RGB5:
+		case GL_RGB5_A1:
+			return width * height * 2;
+		case GL_RGB:
+			return width * height * 3;
+		default:
+			return width * height * 4;
+	}
+}
+
+/*
+ * renderer_img_formatName
+ */
+const char *renderer_img_formatName(int format, eboolean atlased)
+{
+	if(atlased)
+		return "atlas";
+
+	switch(format)
+	{
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:	return "BC1";
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:	return "BC3";
+		case GL_RGB5:							return "RGB5";
+		case GL_RGB5_A1:						return "RGB5_A1";
+		case GL_RGB:							return "RGB8";
+		case GL_RGBA:							return "RGBA8";
+		default:								return "other";
+	}
+}
+
+/*
+ * renderer_img_textureBytes
+ * What a texture's levels from level down take up, as uploaded.
+ */
+int renderer_img_textureBytes(const texture_t *texture, int level)
+{
+	int i, width, height, bytes;
+
+	width  = texture->width;
+	height = texture->height;
+
+	for(i = 0, bytes = 0; i < texture->numLevels; i++)
+	{
+		if(i >= level)
+			bytes += renderer_img_formatBytes(texture->format, width, height);
+
+		width  = width  > 1 ? width  / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return bytes;
+}
+
+/*
+ * stats_residentBytes
+ * Only the levels a streamed texture has in at the moment count.
+ */
+static int stats_residentBytes(int handle)
+{
+	const texture_t *texture;
+
+	if(handle == NO_TEXTURE || renderer_img_getTextureName(handle) == NULL)
+		return 0;
+
+	texture = renderer_img_getTexture(handle);
+	return renderer_img_textureBytes(texture, texture->baseLevel);
+}
+
+/*
+ * stats_duplicateOf
+ * The first live texture with the same pixels as this one, NO_TEXTURE if
+ * there isn't one before it.
+ */
+static int stats_duplicateOf(int handle)
+{
+	const texture_t	*texture, *other;
+	int				i;
+
+	texture = renderer_img_getTexture(handle);
+	if(!texture->hash)
+		return NO_TEXTURE;
+
+	for(i = 0; i < handle; i++)
+	{
+		if(renderer_img_getTextureName(i) == NULL)
+			continue;
+
+		other = renderer_img_getTexture(i);
+
+		if(other->hash == texture->hash && other->width == texture->width &&
+		   other->height == texture->height && other->bpp == texture->bpp)
+			return i;
+	}
+
+	return NO_TEXTURE;
+}
+
+/*
+ * renderer_img_getTextureStats
+ * Totals over every texture in the cache right now.
+ */
+void renderer_img_getTextureStats(textureStats_t *stats)
+{
+	const texture_t	*texture;
+	int				i, j, bytes, format, numHandles;
+
+	memset(stats, 0, sizeof(*stats));
+	numHandles = renderer_img_getNumTextureHandles();
+
+	for(i = 0; i < numHandles; i++)
+	{
+		if(renderer_img_getTextureName(i) == NULL)
+			continue;
+
+		texture = renderer_img_getTexture(i);
+		bytes	= stats_residentBytes(i);
+
+		stats->numTextures++;
+		stats->totalBytes += bytes;
+
+		//Everything past the finest level it has in
+		if(texture->baseLevel < texture->numLevels)
+			stats->mipBytes += renderer_img_textureBytes(texture, texture->baseLevel + 1);
+
+		//Atlased textures get a bucket of their own
+		format = texture->atlased ? 0 : texture->format;
+
+		for(j = 0; j < stats->numFormats; j++)
+			if(stats->formats[j] == format)
+				break;
+
+		if(j == stats->numFormats && j < MAX_STAT_FORMATS)
+			stats->formats[stats->numFormats++] = format;
+
+		if(j < stats->numFormats)
+		{
+			stats->formatTextures[j]++;
+			stats->formatBytes[j] += bytes;
+		}
+
+		if(stats_duplicateOf(i) != NO_TEXTURE)
+		{
+			stats->numDuplicates++;
+			stats->duplicateBytes += bytes;
+		}
+	}
+}
+
+/*
+ * renderer_img_getMaterialBytes
+ * What the material's texture takes up, shared or not.
+ */
+int renderer_img_getMaterialBytes(int i)
+{
+	return stats_residentBytes(renderer_img_getMatTexture(i));
+}
+
+/*
+ * stats_modelBytes
+ * Every texture a model's objects use, each counted once.
+ */
+static int stats_modelBytes(int model, int *numTextures)
+{
+	int handles[MAX_TEXTURES];
+	int i, j, handle, material, bytes;
+
+	*numTextures = 0;
+
+	for(i = 0, bytes = 0; i < renderer_model_getNumObjects(model); i++)
+	{
+		material = renderer_model_getObjectMaterial(model, i);
+		if(material < 0)
+			continue;
+
+		handle = renderer_img_getMatTexture(material);
+		if(handle == NO_TEXTURE)
+			continue;
+
+		for(j = 0; j < *numTextures; j++)
+			if(handles[j] == handle)
+				break;
+
+		if(j < *numTextures)
+			continue;
+
+		handles[(*numTextures)++] = handle;
+		bytes += stats_residentBytes(handle);
+	}
+
+	return bytes;
+}
+
+/*
+ * renderer_img_reportTextureStats
+ */
+void renderer_img_reportTextureStats()
+{
+	textureStats_t	stats;
+	int				i;
+
+	renderer_img_getTextureStats(&stats);
+
+	printf("Texture memory: %d textures, %d KB, %d KB of it mip levels, %d duplicates (%d KB)\n",
+			stats.numTextures, stats.totalBytes / 1024, stats.mipBytes / 1024,
+			stats.numDuplicates, stats.duplicateBytes / 1024);
+
+	for(i = 0; i < stats.numFormats; i++)
+		printf("  %-8s %4d textures, %d KB\n", renderer_img_formatName(stats.formats[i], stats.formats[i] == 0),
+				stats.formatTextures[i], stats.formatBytes[i] / 1024);
+}
+
+/*
+ * stats_dumpText
+ */
+static void stats_dumpText(FILE *file, const textureStats_t *stats)
+{
+	const texture_t	*texture;
+	int				i, duplicate, numTextures;
+
+	fprintf(file, "Texture memory: %d textures, %d KB, %d KB of it mip levels\n\n",
+			stats->numTextures, stats->totalBytes / 1024, stats->mipBytes / 1024);
+
+	fprintf(file, "By format:\n");
+	for(i = 0; i < stats->numFormats; i++)
+		fprintf(file, "  %-8s %4d textures %8d KB\n", renderer_img_formatName(stats->formats[i], stats->formats[i] == 0),
+				stats->formatTextures[i], stats->formatBytes[i] / 1024);
+
+	fprintf(file, "\nTextures:\n  %8s  %-11s  %-8s  %6s  %5s  %s\n", "KB", "Size", "Format", "Levels", "Users", "Name");
+	for(i = 0; i < renderer_img_getNumTextureHandles(); i++)
+	{
+		if(renderer_img_getTextureName(i) == NULL)
+			continue;
+
+		texture = renderer_img_getTexture(i);
+		fprintf(file, "  %8d  %5dx%-5d  %-8s  %2d/%-3d  %5d  %s\n", stats_residentBytes(i) / 1024,
+				texture->width, texture->height, renderer_img_formatName(texture->format, texture->atlased),
+				texture->numLevels - texture->baseLevel, texture->numLevels, renderer_img_getTextureUsers(i),
+				renderer_img_getTextureName(i));
+	}
+
+	fprintf(file, "\nMaterials:\n  %4s  %8s  %s\n", "#", "KB", "Texture");
+	for(i = 0; i < renderer_img_getNumMaterials(); i++)
+		fprintf(file, "  %4d  %8d  %s%s\n", i, renderer_img_getMaterialBytes(i) / 1024, renderer_img_getMatName(i),
+				renderer_img_getMatTexture(i) != NO_TEXTURE &&
+				renderer_img_getTextureUsers(renderer_img_getMatTexture(i)) > 1 ? " (shared)" : "");
+
+	fprintf(file, "\nModels:\n  %8s  %8s  %s\n", "KB", "Textures", "Name");
+	for(i = 0; i < renderer_model_getNumModels(); i++)
+	{
+		fprintf(file, "  %8d", stats_modelBytes(i, &numTextures) / 1024);
+		fprintf(file, "  %8d  %s\n", numTextures, renderer_model_getName(i));
+	}
+
+	fprintf(file, "\nDuplicates: %d, %d KB\n", stats->numDuplicates, stats->duplicateBytes / 1024);
+	for(i = 0; i < renderer_img_getNumTextureHandles(); i++)
+	{
+		if(renderer_img_getTextureName(i) == NULL || (duplicate = stats_duplicateOf(i)) == NO_TEXTURE)
+			continue;
+
+		fprintf(file, "  %s is the same as %s, %d KB\n", renderer_img_getTextureName(i),
+				renderer_img_getTextureName(duplicate), stats_residentBytes(i) / 1024);
+	}
+}
+
+/*
+ * stats_dumpCSV
+ * One row per texture, material, model and format, all with the same
+ * columns. For models and formats users is how many textures they have.
+ */
+static void stats_dumpCSV(FILE *file, const textureStats_t *stats)
+{
+	const texture_t	*texture;
+	int				i, handle, duplicate, numTextures, bytes;
+
+	fprintf(file, "kind,name,width,height,format,levels,users,bytes,duplicate_of\n");
+
+	for(i = 0; i < renderer_img_getNumTextureHandles(); i++)
+	{
+		if(renderer_img_getTextureName(i) == NULL)
+			continue;
+
+		texture	  = renderer_img_getTexture(i);
+		duplicate = stats_duplicateOf(i);
+
+		fprintf(file, "texture,\"%s\",%d,%d,%s,%d,%d,%d,\"%s\"\n", renderer_img_getTextureName(i),
+				texture->width, texture->height, renderer_img_formatName(texture->format, texture->atlased),
+				texture->numLevels - texture->baseLevel, renderer_img_getTextureUsers(i), stats_residentBytes(i),
+				duplicate != NO_TEXTURE ? renderer_img_getTextureName(duplicate) : "");
+	}
+
+	for(i = 0; i < renderer_img_getNumMaterials(); i++)
+	{
+		handle = renderer_img_getMatTexture(i);
+
+		if(handle == NO_TEXTURE)
+		{
+			fprintf(file, "material,\"%s\",0,0,,0,0,0,\n", renderer_img_getMatName(i));
+			continue;
+		}
+
+		texture = renderer_img_getTexture(handle);
+		fprintf(file, "material,\"%s\",%d,%d,%s,%d,%d,%d,\n", renderer_img_getMatName(i),
+				texture->width, texture->height, renderer_img_formatName(texture->format, texture->atlased),
+				texture->numLevels - texture->baseLevel, renderer_img_getTextureUsers(handle),
+				renderer_img_getMaterialBytes(i));
+	}
+
+	for(i = 0; i < renderer_model_getNumModels(); i++)
+	{
+		bytes = stats_modelBytes(i, &numTextures);
+		fprintf(file, "model,\"%s\",,,,,%d,%d,\n", renderer_model_getName(i), numTextures, bytes);
+	}
+
+	for(i = 0; i < stats->numFormats; i++)
+		fprintf(file, "format,%s,,,,,%d,%d,\n", renderer_img_formatName(stats->formats[i], stats->formats[i] == 0),
+				stats->formatTextures[i], stats->formatBytes[i]);
+}
+
+/*
+ * renderer_img_dumpTextureStats
+ * Writes everything out, as CSV if the name ends in .csv and as text
+ * otherwise.
+ */
+eboolean renderer_img_dumpTextureStats(const char *fileName)
+{
+	textureStats_t	stats;
+	FILE			*file;
+	int				len;
+
+	file = fopen(fileName, "w");
+	if(file == NULL)
+	{
+		printf("Texture stats: could not write %s\n", fileName);
+		return efalse;
+	}
+
+	renderer_img_getTextureStats(&stats);
+
+	len = strlen(fileName);
+
+	if(len > 4 && !strcmp(fileName + len - 4, ".csv"))
+		stats_dumpCSV(file, &stats);
+	else
+		stats_dumpText(file, &stats);
+
+	fclose(file);
+
+	printf("Texture stats: written to %s\n", fileName);
+	return etrue;
+}
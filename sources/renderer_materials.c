@@ -19,11 +19,17 @@ Notes:		Please remember that this is, for the moment, basically
 
 typedef struct
 {
-	int		glTexID;
 	char	name[128];
 	vec3_t	ambient, diffuse, specular;
 	float	shine, shineStrength, transparency;
 	int		width, height, bpp;
+
+	//Set if the image lives on a shared atlas page: s/t scale, s/t offset
+	eboolean	atlased;
+	float		atlas[4];
+
+	//Handle from the texture cache, the fields above are copied out of it
+	int		texture;
 }
 material_t;
 
@@ -32,11 +38,15 @@ static int stackPtr = 0;
 
 /*
  * renderer_img_createMaterial
+ * With atlas set, a small enough image is packed into a shared page
+ * instead of getting its own texture. Only ask for that if the texture
+ * coordinates using it stay within [0,1].
  */
 int renderer_img_createMaterial(char *name, vec3_t ambient, vec3_t diffuse, vec3_t specular,
-		float shine, float shineStrength, float transparency)
+		float shine, float shineStrength, float transparency, eboolean atlas)
 {
-	material_t *currentMat = &materialList[stackPtr];
+	material_t		*currentMat = &materialList[stackPtr];
+	const texture_t	*texture;
 
 	currentMat->shine 			= shine;
 	currentMat->shineStrength 	= shineStrength;
@@ -48,13 +58,95 @@ int renderer_img_createMaterial(char *name, vec3_t ambient, vec3_t diffuse, vec3
 	VectorCopy(diffuse,  currentMat->diffuse);
 	VectorCopy(specular, currentMat->specular);
 
-	renderer_img_loadTGA(name, &(currentMat->glTexID),
-			&(currentMat->width), &(currentMat->height), &(currentMat->bpp));
+	currentMat->texture = renderer_img_acquireTexture(name, atlas);
+
+	if(currentMat->texture == NO_TEXTURE)
+	{
+		currentMat->width	= currentMat->height = currentMat->bpp = 0;
+		currentMat->atlased = efalse;
+
+		return stackPtr++;
+	}
+
+	texture = renderer_img_getTexture(currentMat->texture);
+
+	currentMat->width	= texture->width;
+	currentMat->height	= texture->height;
+	currentMat->bpp		= texture->bpp;
+	currentMat->atlased	= texture->atlased;
+	memcpy(currentMat->atlas, texture->atlas, sizeof(currentMat->atlas));
 
 	return stackPtr++;
 }
 
-int renderer_img_getMatGLID  (int i) { return materialList[i].glTexID; }
+/*
+ * renderer_img_clearMaterials
+ * Lets go of every material's texture.
+ */
+void renderer_img_clearMaterials()
+{
+	int i;
+
+	for(i = 0; i < stackPtr; i++)
+		renderer_img_releaseTexture(materialList[i].texture);
+
+	stackPtr = 0;
+}
+
+/*
+ * renderer_img_getMatGLID
+ * Read from the cache every time, a background load that fails takes the
+ * texture's name away after the material has been made.
+ */
+int renderer_img_getMatGLID(int i)
+{
+	if(materialList[i].texture == NO_TEXTURE)
+		return 0;
+
+	return renderer_img_getTexture(materialList[i].texture)->glTexID;
+}
+
 int renderer_img_getMatWidth (int i) { return materialList[i].width;   }
 int renderer_img_getMatHeight(int i) { return materialList[i].height;  }
 int renderer_img_getMatBpp   (int i) { return materialList[i].bpp;     }
+
+float renderer_img_getMatTransparency(int i) { return materialList[i].transparency; }
+
+int renderer_img_getNumMaterials() { return stackPtr; }
+int renderer_img_getMatTexture(int i) { return materialList[i].texture; }
+const char *renderer_img_getMatName(int i) { return materialList[i].name; }
+
+/*
+ * renderer_img_getMatLighting
+ */
+void renderer_img_getMatLighting(int i, vec3_t ambient, vec3_t diffuse, vec3_t specular, float *shine)
+{
+	VectorCopy(materialList[i].ambient,  ambient);
+	VectorCopy(materialList[i].diffuse,  diffuse);
+	VectorCopy(materialList[i].specular, specular);
+
+	*shine = materialList[i].shine;
+}
+
+/*
+ * renderer_img_touchMaterial
+ * Call whenever something using the material is drawn, streaming goes by
+ * it.
+ */
+void renderer_img_touchMaterial(int i)
+{
+	renderer_img_touchTexture(materialList[i].texture);
+}
+
+/*
+ * renderer_img_getMatAtlas
+ * Returns efalse if the material has a texture to itself.
+ */
+eboolean renderer_img_getMatAtlas(int i, float *scaleOffset)
+{
+	if(!materialList[i].atlased)
+		return efalse;
+
+	memcpy(scaleOffset, materialList[i].atlas, sizeof(float) * 4);
+	return etrue;
+}
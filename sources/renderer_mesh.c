@@ -0,0 +1,441 @@
+/*
+===========================================================================
+File:		renderer_mesh.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Static meshes that never change after load. The geometry goes
+			into a buffer object once and every image the mesh uses is
+			packed into one texture, so drawing it is a single bind and a
+			single draw call.
+
+			Once everything is loaded all the meshes can also be packed
+			into one shared vertex buffer and one index buffer. Any number
+			of them with the same texture are then drawn with a single
+			glMultiDrawElementsIndirect, or a glDrawElements loop over the
+			same commands where that isn't supported.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_materials.h"
+#include "headers/renderer_atlas.h"
+#include "headers/renderer_glext.h"
+#include "headers/renderer_mesh.h"
+
+//s, t, x, y, z
+#define MESH_VERTEX_SIZE 5
+
+typedef struct
+{
+	int		numVerts;
+	GLuint	texture;
+	GLuint	vbo;
+
+	//Kept around to be packed into the shared buffers
+	float	*verts;
+
+	//Where the mesh landed in the shared index buffer
+	int		firstIndex, numIndices;
+}
+staticMesh_t;
+
+static staticMesh_t meshes[MAX_STATIC_MESHES];
+static int numMeshes = 0;
+
+//Shared buffers
+static GLuint				sharedVerts = 0, sharedIndices = 0, indirectBuffer = 0;
+
+//This frame's commands, for when they have to be walked on the CPU
+static const indirectCmd_t	*indirectCmds = NULL;
+
+/*
+ * renderer_mesh_nextPow2
+ */
+static int renderer_mesh_nextPow2(int x)
+{
+	int p = 1;
+
+	while(p < x)
+		p <<= 1;
+
+	return p;
+}
+
+/*
+ * renderer_mesh_createStatic
+ * Builds the mesh and its atlas. Returns the mesh index, or -1 if any of
+ * the images couldn't be loaded or there's no memory for it.
+ */
+int renderer_mesh_createStatic(int numQuads, const float *quads, char **images)
+{
+	staticMesh_t	*mesh;
+	image_t			loaded[MAX_MESH_IMAGES];
+	char			*names[MAX_MESH_IMAGES];
+	int				rects[MAX_MESH_IMAGES][2];
+	int				imageOf[MAX_MESH_IMAGES * 4];
+	int				order[MAX_MESH_IMAGES];
+	int				numImages, i, j, k, x, y, w, h, area, width, height;
+	skyline_t		sky;
+	float			*verts, *v;
+	byte			*atlas;
+
+	if(numMeshes >= MAX_STATIC_MESHES || numQuads > MAX_MESH_IMAGES * 4)
+	{
+		printf("Creating static mesh failed. Too many meshes or quads.\n");
+		return -1;
+	}
+
+	//Load every distinct image once
+	numImages = 0;
+	for(i = 0; i < numQuads; i++)
+	{
+		for(j = 0; j < numImages; j++)
+			if(!strcmp(names[j], images[i]))
+				break;
+
+		if(j == numImages)
+		{
+			if(numImages >= MAX_MESH_IMAGES || !renderer_img_decodeTGA(images[i], &loaded[j]))
+			{
+				while(--numImages >= 0)
+					renderer_img_freeImage(&loaded[numImages]);
+				return -1;
+			}
+
+			names[numImages++] = images[i];
+		}
+
+		imageOf[i] = j;
+	}
+
+	//Tallest first packs tighter. Start from a square that could hold the
+	//total area and double it until everything fits.
+	for(i = 0; i < numImages; i++)
+		order[i] = i;
+
+	for(i = 1; i < numImages; i++)
+		for(j = i; j > 0 && loaded[order[j]].height > loaded[order[j - 1]].height; j--)
+		{
+			k			 = order[j];
+			order[j]	 = order[j - 1];
+			order[j - 1] = k;
+		}
+
+	area = 0;
+	width = 1;
+	for(i = 0; i < numImages; i++)
+	{
+		w = loaded[i].width  + ATLAS_PADDING * 2;
+		h = loaded[i].height + ATLAS_PADDING * 2;
+		area += w * h;
+		if(w > width)
+			width = w;
+		if(h > width)
+			width = h;
+	}
+
+	width = renderer_mesh_nextPow2(width);
+	while(width * width < area)
+		width *= 2;
+
+	for(;;)
+	{
+		renderer_atlas_skylineInit(&sky, width, width);
+		height = 0;
+
+		for(i = 0; i < numImages; i++)
+		{
+			j = order[i];
+			w = loaded[j].width  + ATLAS_PADDING * 2;
+			h = loaded[j].height + ATLAS_PADDING * 2;
+
+			if(!renderer_atlas_skylineInsert(&sky, w, h, &x, &y))
+				break;
+
+			rects[j][0] = x + ATLAS_PADDING;
+			rects[j][1] = y + ATLAS_PADDING;
+
+			if(y + h > height)
+				height = y + h;
+		}
+
+		if(i == numImages)
+			break;
+
+		width *= 2;
+	}
+
+	height = renderer_mesh_nextPow2(height);
+
+	atlas = (byte *)calloc(width * height, 4);
+	verts = (float *)malloc(sizeof(float) * MESH_VERTEX_SIZE * numQuads * 4);
+
+	if(atlas == NULL || verts == NULL)
+	{
+		printf("Creating static mesh failed. Out of memory for a %dx%d atlas.\n", width, height);
+
+		free(atlas);
+		free(verts);
+		for(i = 0; i < numImages; i++)
+			renderer_img_freeImage(&loaded[i]);
+		return -1;
+	}
+
+	for(i = 0; i < numImages; i++)
+		renderer_atlas_blit(atlas, width, &loaded[i], rects[i][0], rects[i][1], ATLAS_PADDING, etrue);
+
+	printf("Static mesh %d: %d images in a %dx%d atlas, %.1f%% used\n", numMeshes,
+			numImages, width, height, 100.0 * sky.usedArea / (width * height));
+
+	mesh = &meshes[numMeshes];
+
+	glGenTextures(1, &mesh->texture);
+	glBindTexture(GL_TEXTURE_2D, mesh->texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
+			0, GL_RGBA, GL_UNSIGNED_BYTE, atlas);
+
+	free(atlas);
+
+	//Move the texture coordinates into each image's spot in the atlas
+	mesh->numVerts = numQuads * 4;
+	memcpy(verts, quads, sizeof(float) * MESH_VERTEX_SIZE * mesh->numVerts);
+
+	for(i = 0; i < mesh->numVerts; i++)
+	{
+		v = verts + i * MESH_VERTEX_SIZE;
+		j = imageOf[i / 4];
+
+		v[0] = (rects[j][0] + v[0] * loaded[j].width)  / (float)width;
+		v[1] = (rects[j][1] + v[1] * loaded[j].height) / (float)height;
+	}
+
+	for(i = 0; i < numImages; i++)
+		renderer_img_freeImage(&loaded[i]);
+
+	if(glConfig.vertexBufferObject)
+	{
+		qglGenBuffers(1, &mesh->vbo);
+		qglBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+		qglBufferData(GL_ARRAY_BUFFER, sizeof(float) * MESH_VERTEX_SIZE * mesh->numVerts,
+				verts, GL_STATIC_DRAW);
+		qglBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+		mesh->vbo = 0;
+
+	mesh->verts		 = verts;
+	mesh->firstIndex = mesh->numIndices = 0;
+
+	return numMeshes++;
+}
+
+/*
+ * renderer_mesh_drawStatic
+ * Render command callback, expects the mesh's texture to be bound already.
+ */
+void renderer_mesh_drawStatic(int index)
+{
+	staticMesh_t *mesh;
+
+	if(index < 0 || index >= numMeshes)
+		return;
+
+	mesh = &meshes[index];
+
+	glColor3f(1.0, 1.0, 1.0);
+
+	if(mesh->vbo)
+	{
+		qglBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+		glInterleavedArrays(GL_T2F_V3F, 0, NULL);
+	}
+	else
+		glInterleavedArrays(GL_T2F_V3F, 0, mesh->verts);
+
+	glDrawArrays(GL_QUADS, 0, mesh->numVerts);
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if(mesh->vbo)
+		qglBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+ * renderer_mesh_getTexture
+ */
+int renderer_mesh_getTexture(int index)
+{
+	if(index < 0 || index >= numMeshes)
+		return 0;
+
+	return meshes[index].texture;
+}
+
+/*
+ * renderer_mesh_buildShared
+ * Packs every static mesh into one vertex buffer, with the quads split
+ * into triangles in one index buffer. Indices are absolute, so commands
+ * never need a base vertex. Call once after the last mesh is created.
+ * Without the memory for it, meshes are drawn one call each as if there
+ * were no vertex buffers.
+ */
+void renderer_mesh_buildShared()
+{
+	staticMesh_t	*mesh;
+	float			*verts;
+	GLuint			*indices, *index;
+	int				i, j, numVerts, numIndices, base;
+
+	if(!glConfig.vertexBufferObject || numMeshes == 0 || sharedVerts)
+		return;
+
+	numVerts = 0;
+	for(i = 0; i < numMeshes; i++)
+		numVerts += meshes[i].numVerts;
+
+	numIndices = numVerts / 4 * 6;
+
+	verts	= (float *)malloc(sizeof(float) * MESH_VERTEX_SIZE * numVerts);
+	indices = (GLuint *)malloc(sizeof(GLuint) * numIndices);
+
+	if(verts == NULL || indices == NULL)
+	{
+		printf("Static meshes: out of memory for shared buffers, drawing one call each\n");
+
+		free(verts);
+		free(indices);
+		return;
+	}
+
+	index	= indices;
+	base	= 0;
+
+	for(i = 0; i < numMeshes; i++)
+	{
+		mesh = &meshes[i];
+
+		memcpy(verts + base * MESH_VERTEX_SIZE, mesh->verts, sizeof(float) * MESH_VERTEX_SIZE * mesh->numVerts);
+
+		mesh->firstIndex = index - indices;
+		mesh->numIndices = mesh->numVerts / 4 * 6;
+
+		for(j = base; j < base + mesh->numVerts; j += 4)
+		{
+			*index++ = j;
+			*index++ = j + 1;
+			*index++ = j + 2;
+			*index++ = j;
+			*index++ = j + 2;
+			*index++ = j + 3;
+		}
+
+		base += mesh->numVerts;
+	}
+
+	qglGenBuffers(1, &sharedVerts);
+	qglBindBuffer(GL_ARRAY_BUFFER, sharedVerts);
+	qglBufferData(GL_ARRAY_BUFFER, sizeof(float) * MESH_VERTEX_SIZE * numVerts, verts, GL_STATIC_DRAW);
+	qglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	qglGenBuffers(1, &sharedIndices);
+	qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedIndices);
+	qglBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * numIndices, indices, GL_STATIC_DRAW);
+	qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	if(glConfig.multiDrawIndirect)
+		qglGenBuffers(1, &indirectBuffer);
+
+	free(verts);
+	free(indices);
+
+	printf("Static meshes: %d meshes, %d vertices, %d indices in shared buffers, %s\n", numMeshes,
+			numVerts, numIndices, indirectBuffer ? "multi-draw indirect" : "draw loop");
+}
+
+/*
+ * renderer_mesh_getIndirect
+ * Fills in the command that draws the whole mesh. False if the shared
+ * buffers weren't built.
+ */
+eboolean renderer_mesh_getIndirect(int index, indirectCmd_t *cmd)
+{
+	if(!sharedVerts || index < 0 || index >= numMeshes)
+		return efalse;
+
+	cmd->count		   = meshes[index].numIndices;
+	cmd->instanceCount = 1;
+	cmd->firstIndex	   = meshes[index].firstIndex;
+	cmd->baseVertex	   = 0;
+	cmd->baseInstance  = 0;
+
+	return etrue;
+}
+
+/*
+ * renderer_mesh_uploadIndirect
+ * Every command drawn this frame, in one upload. cmds has to stay valid
+ * until the last renderer_mesh_drawIndirect of the frame.
+ */
+void renderer_mesh_uploadIndirect(const indirectCmd_t *cmds, int count)
+{
+	indirectCmds = cmds;
+
+	if(!indirectBuffer)
+		return;
+
+	qglBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	qglBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(indirectCmd_t) * count, cmds, GL_STREAM_DRAW);
+	qglBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/*
+ * renderer_mesh_drawIndirect
+ * Draws count of the uploaded commands, starting at first. They all have
+ * to share the texture that's bound.
+ */
+void renderer_mesh_drawIndirect(int first, int count)
+{
+	const indirectCmd_t	*cmd;
+	int					i;
+
+	if(!sharedVerts || indirectCmds == NULL)
+		return;
+
+	glColor3f(1.0, 1.0, 1.0);
+
+	qglBindBuffer(GL_ARRAY_BUFFER, sharedVerts);
+	glInterleavedArrays(GL_T2F_V3F, 0, NULL);
+	qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sharedIndices);
+
+	if(indirectBuffer)
+	{
+		qglBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+		qglMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+				(void *)(first * sizeof(indirectCmd_t)), count, 0);
+		qglBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	else
+	{
+		for(i = 0, cmd = indirectCmds + first; i < count; i++, cmd++)
+			glDrawElements(GL_TRIANGLES, cmd->count, GL_UNSIGNED_INT,
+					(void *)(cmd->firstIndex * sizeof(GLuint)));
+	}
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	qglBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	qglBindBuffer(GL_ARRAY_BUFFER, 0);
+}
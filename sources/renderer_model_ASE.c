@@ -17,9 +17,13 @@ Notes:		Please remember that this is, for the moment, basically
 
 #include "headers/renderer_materials.h"
 #include "headers/renderer_models.h"
+#include "headers/renderer_occlusion.h"
 
 static void loadASE_parseTokens(char **tokens, int numTokens, eboolean collidable);
-static void loadASE_generateList(int index);
+static void loadASE_generateList(int index, int object);
+static void loadASE_computeBounds(int index);
+static eboolean loadASE_canAtlas(int index, int material);
+static void loadASE_applyAtlas(int index);
 
 /*
 ===========================================================================
@@ -110,15 +114,29 @@ typedef struct
 	char 		name[MAX_NAMELENGTH];
 	ase_mesh_t 	mesh;
 	int			materialRef;
+	vec3_t		mins, maxs;
+	int			glListID;
+	float		alpha;
+
+	//The texture its list was compiled binding
+	int			glTexID;
 }
 ase_geomObject_t;
 
 typedef struct
 {
+	char				name[MAX_FILEPATH];
 	int 				numObjects;
 	int					glListID;
 	ase_geomObject_t	*objects;
 	ase_materialList_t	materials;
+	vec3_t				mins, maxs;
+
+	//Packed copy of the triangles for the software occlusion buffer
+	eboolean			occluder;
+	int					occNumVerts, occNumTris;
+	float				*occVerts;
+	int					*occIndices;
 }
 ase_model_t;
 
@@ -134,6 +152,10 @@ static void loadASE_printMesh(ase_mesh_t *mesh);
 static void loadASE_printGeomObject(ase_geomObject_t *geomObject);
 static void loadASE_printModel(ase_model_t *model);
 
+//How far outside [0,1] a texture coordinate can be and still count as
+//not wrapping
+#define ATLAS_UV_EPSILON 0.001
+
 static ase_model_t 	modelStack[MAX_MODELS];
 static int 			modelPtr = 0;
 
@@ -142,13 +164,14 @@ static int 			modelPtr = 0;
  */
 void renderer_model_loadASE(char *name, eboolean collidable)
 {
-	FILE 			*file;
-	unsigned int	fileSize;
+	const byte		*file;
+	byte			*fileBuf;
+	int				fileSize;
 	char 			*fileBuffer, **tokens;
-	unsigned int	numTokens, blah;
+	unsigned int	numTokens;
 
-	//Attempt to load the specified file
-	file = fopen(name, "r");
+	//Attempt to load the specified file, out of the pack if it's there
+	file = files_loadAsset(name, &fileSize, &fileBuf);
 
 	if(file == NULL)
 	{
@@ -156,22 +179,23 @@ void renderer_model_loadASE(char *name, eboolean collidable)
 		return;
 	}
 
-	//Determine the size of the file
-	fseek(file, 0, SEEK_END);
-	fileSize = ftell(file);
-	rewind(file);
-
-	//If successful, load the file's contents into a buffer
-	fileBuffer = (char *)malloc(sizeof(char) * fileSize);
-	blah = fread(fileBuffer, sizeof(char), fileSize+1, file);
-	fileBuffer[blah] = '\0';
-
-	fclose(file);
+	//A file of its own comes with a terminator, one in the pack has to be
+	//copied out to get one
+	if(fileBuf != NULL)
+		fileBuffer = (char *)fileBuf;
+	else
+	{
+		fileBuffer = (char *)malloc(fileSize + 1);
+		memcpy(fileBuffer, file, fileSize);
+		fileBuffer[fileSize] = '\0';
+	}
 
 	//Break the file into a new array of tokens
 	numTokens = files_tokenizeStr(fileBuffer, " \t\n\r\0", &tokens);
 	free(fileBuffer);
 
+	strncpy(modelStack[modelPtr].name, name, MAX_FILEPATH - 1);
+
 	loadASE_parseTokens(tokens, numTokens, collidable);
 }
 
@@ -194,8 +218,9 @@ static void loadASE_parseTokens(char **tokens, int numTokens, eboolean collidabl
 		{
 			model->materials.materialCount = atoi(tokens[++i]);
 
-			//Allocate enough space for the given number of materials.
-			model->materials.list = (ase_material_t *)malloc(sizeof(ase_material_t) * model->materials.materialCount);
+			//Allocate enough space for the given number of materials. Zeroed,
+			//since not every exporter writes out every field (transparency).
+			model->materials.list = (ase_material_t *)calloc(model->materials.materialCount, sizeof(ase_material_t));
 		}
 		else if(!strcmp(tokens[i], "*MATERIAL"))
 		{
@@ -423,13 +448,18 @@ static void loadASE_parseTokens(char **tokens, int numTokens, eboolean collidabl
 	{
 		model->materials.list[i].globalID = renderer_img_createMaterial(model->materials.list[i].diffuseMap.bitmap,
 				model->materials.list[i].ambient, model->materials.list[i].diffuse, model->materials.list[i].specular,
-				model->materials.list[i].shine, model->materials.list[i].shineStrength, model->materials.list[i].transparency);
+				model->materials.list[i].shine, model->materials.list[i].shineStrength, model->materials.list[i].transparency,
+				loadASE_canAtlas(modelPtr, i));
 	}
 
 	//Correct the mesh's references to point to the global material
 	for(i = 0; i < model->numObjects; i++)
 		model->objects[i].materialRef = model->materials.list[model->objects[i].materialRef].globalID;
 
+	loadASE_applyAtlas(modelPtr);
+
+	loadASE_computeBounds(modelPtr);
+
 	/*
 	//Potentially add triangles to collision list
 	if(collidable)
@@ -453,10 +483,24 @@ static void loadASE_parseTokens(char **tokens, int numTokens, eboolean collidabl
 	}
 	*/
 
-	//Generate a display list for drawing
+	//Generate a display list for each geom object, so that translucent
+	//ones can be sorted and drawn on their own
+	for(i = 0; i < model->numObjects; i++)
+	{
+		model->objects[i].alpha    = 1.0 - renderer_img_getMatTransparency(model->objects[i].materialRef);
+		model->objects[i].glListID = glGenLists(1);
+
+		glNewList(model->objects[i].glListID, GL_COMPILE);
+			loadASE_generateList(modelPtr, i);
+		glEndList();
+	}
+
+	//And one for everything opaque
 	model->glListID = glGenLists(1);
 	glNewList(model->glListID, GL_COMPILE);
-		loadASE_generateList(modelPtr);
+		for(i = 0; i < model->numObjects; i++)
+			if(model->objects[i].alpha >= 1.0)
+				glCallList(model->objects[i].glListID);
 	glEndList();
 
 	modelPtr++;
@@ -464,57 +508,297 @@ static void loadASE_parseTokens(char **tokens, int numTokens, eboolean collidabl
 
 /*
  * loadASE_generateList
+ * Emits the GL calls for one geom object, to be compiled into its list.
  */
-static void loadASE_generateList(int index)
+static void loadASE_generateList(int index, int object)
 {
-	int i, j;
-	ase_model_t 		*model;
+	int j;
+	ase_geomObject_t	*geomObject;
 	ase_mesh_vertex_t 	*vertexList;
 	ase_mesh_face_t 	*faceList;
 	ase_mesh_tface_t 	*tfaceList;
 	ase_mesh_tvertex_t 	*tvertList;
 
+	geomObject = &(modelStack[index].objects[object]);
+
+	vertexList  = geomObject->mesh.vertexList;
+	tvertList   = geomObject->mesh.tvertList;
+	faceList    = geomObject->mesh.faceList;
+	tfaceList   = geomObject->mesh.tfaceList;
+
+	geomObject->glTexID = renderer_img_getMatGLID(geomObject->materialRef);
+	glBindTexture(GL_TEXTURE_2D, geomObject->glTexID);
+
+	for(j = 0; j < geomObject->mesh.numFaces; j++)
+	{
+		glBegin(GL_POLYGON);
+			glNormal3fv(faceList[j].normal);
+
+			//glNormal3fv(vertexList[faceList[j].A].normal);
+			glTexCoord3fv(tvertList[tfaceList[j].a].coords);
+			glVertex3fv(vertexList[faceList[j].A].coords);
+
+			//glNormal3fv(vertexList[faceList[j].B].normal);
+			glTexCoord3fv(tvertList[tfaceList[j].b].coords);
+			glVertex3fv(vertexList[faceList[j].B].coords);
+
+			//glNormal3fv(vertexList[faceList[j].C].normal);
+			glTexCoord3fv(tvertList[tfaceList[j].c].coords);
+			glVertex3fv(vertexList[faceList[j].C].coords);
+		glEnd();
+	}
+}
+
+/*
+ * loadASE_canAtlas
+ * A material can go on an atlas page if none of the texture coordinates
+ * that use it wrap. Called while materialRef is still the local index.
+ */
+static eboolean loadASE_canAtlas(int index, int material)
+{
+	int			i, j;
+	ase_model_t	*model;
+	ase_mesh_t	*mesh;
+
 	model = &(modelStack[index]);
 
 	for(i = 0; i < model->numObjects; i++)
 	{
-		vertexList  = model->objects[i].mesh.vertexList;
-		tvertList   = model->objects[i].mesh.tvertList;
-		faceList    = model->objects[i].mesh.faceList;
-		tfaceList   = model->objects[i].mesh.tfaceList;
+		if(model->objects[i].materialRef != material)
+			continue;
 
-		glBindTexture(GL_TEXTURE_2D,
-				renderer_img_getMatGLID(model->objects[i].materialRef));
+		mesh = &(model->objects[i].mesh);
 
-		for(j = 0; j < model->objects[i].mesh.numFaces; j++)
+		for(j = 0; j < mesh->numTVertex; j++)
 		{
-			glBegin(GL_POLYGON);
-				glNormal3fv(faceList[j].normal);
+			if(mesh->tvertList[j].coords[_X] < -ATLAS_UV_EPSILON || mesh->tvertList[j].coords[_X] > 1.0 + ATLAS_UV_EPSILON ||
+			   mesh->tvertList[j].coords[_Y] < -ATLAS_UV_EPSILON || mesh->tvertList[j].coords[_Y] > 1.0 + ATLAS_UV_EPSILON)
+				return efalse;
+		}
+	}
 
-				//glNormal3fv(vertexList[faceList[j].A].normal);
-				glTexCoord3fv(tvertList[tfaceList[j].a].coords);
-				glVertex3fv(vertexList[faceList[j].A].coords);
+	return etrue;
+}
 
-				//glNormal3fv(vertexList[faceList[j].B].normal);
-				glTexCoord3fv(tvertList[tfaceList[j].b].coords);
-				glVertex3fv(vertexList[faceList[j].B].coords);
+/*
+ * loadASE_applyAtlas
+ * Moves the texture coordinates of every geom object whose material ended
+ * up on an atlas page into that material's spot on the page.
+ */
+static void loadASE_applyAtlas(int index)
+{
+	int			i, j;
+	float		st[4];
+	ase_model_t	*model;
+	ase_mesh_t	*mesh;
+
+	model = &(modelStack[index]);
+
+	for(i = 0; i < model->numObjects; i++)
+	{
+		if(!renderer_img_getMatAtlas(model->objects[i].materialRef, st))
+			continue;
 
-				//glNormal3fv(vertexList[faceList[j].C].normal);
-				glTexCoord3fv(tvertList[tfaceList[j].c].coords);
-				glVertex3fv(vertexList[faceList[j].C].coords);
-			glEnd();
+		mesh = &(model->objects[i].mesh);
+
+		for(j = 0; j < mesh->numTVertex; j++)
+		{
+			mesh->tvertList[j].coords[_X] = mesh->tvertList[j].coords[_X] * st[0] + st[2];
+			mesh->tvertList[j].coords[_Y] = mesh->tvertList[j].coords[_Y] * st[1] + st[3];
+		}
+	}
+}
+
+/*
+ * loadASE_computeBounds
+ * Axis aligned bounds for every geom object, and for the model as a whole.
+ */
+static void loadASE_computeBounds(int index)
+{
+	int 				i, j, k;
+	ase_model_t 		*model;
+	ase_geomObject_t	*object;
+
+	model = &(modelStack[index]);
+
+	VectorClear(model->mins);
+	VectorClear(model->maxs);
+
+	for(i = 0; i < model->numObjects; i++)
+	{
+		object = &(model->objects[i]);
+
+		VectorClear(object->mins);
+		VectorClear(object->maxs);
+
+		for(j = 0; j < object->mesh.numVertex; j++)
+		{
+			for(k = 0; k < 3; k++)
+			{
+				if(j == 0 || object->mesh.vertexList[j].coords[k] < object->mins[k])
+					object->mins[k] = object->mesh.vertexList[j].coords[k];
+				if(j == 0 || object->mesh.vertexList[j].coords[k] > object->maxs[k])
+					object->maxs[k] = object->mesh.vertexList[j].coords[k];
+			}
+		}
+
+		for(k = 0; k < 3; k++)
+		{
+			if(i == 0 || object->mins[k] < model->mins[k])
+				model->mins[k] = object->mins[k];
+			if(i == 0 || object->maxs[k] > model->maxs[k])
+				model->maxs[k] = object->maxs[k];
+		}
+	}
+}
+
+/*
+ * renderer_model_refreshTextures
+ * Recompiles the lists of geom objects whose material has lost its
+ * texture since, so they don't go on binding a name that can be handed
+ * out again. The opaque lists call them by ID and pick that up.
+ */
+void renderer_model_refreshTextures()
+{
+	int i, j;
+
+	for(i = 0; i < modelPtr; i++)
+	{
+		for(j = 0; j < modelStack[i].numObjects; j++)
+		{
+			if(modelStack[i].objects[j].glTexID == renderer_img_getMatGLID(modelStack[i].objects[j].materialRef))
+				continue;
+
+			glNewList(modelStack[i].objects[j].glListID, GL_COMPILE);
+				loadASE_generateList(i, j);
+			glEndList();
 		}
 	}
 }
 
 /*
  * renderer_model_drawASE
+ * Only draws the opaque geom objects, see renderer_model_drawObject.
  */
 void renderer_model_drawASE(int index)
 {
+	int i;
+
+	for(i = 0; i < modelStack[index].numObjects; i++)
+		if(!renderer_model_isObjectBlended(index, i))
+			renderer_img_touchMaterial(modelStack[index].objects[i].materialRef);
+
 	glCallList(modelStack[index].glListID);
 }
 
+/*
+ * renderer_model_drawObject
+ * Draws a single geom object, with its material's opacity in the current
+ * color. Blending is up to the caller.
+ */
+void renderer_model_drawObject(int index, int object)
+{
+	ase_geomObject_t *obj = &(modelStack[index].objects[object]);
+
+	renderer_img_touchMaterial(obj->materialRef);
+
+	glColor4f(1.0, 1.0, 1.0, obj->alpha);
+	glCallList(obj->glListID);
+}
+
+/*
+ * renderer_model_isObjectBlended
+ */
+eboolean renderer_model_isObjectBlended(int index, int object)
+{
+	return modelStack[index].objects[object].alpha < 1.0;
+}
+
+int renderer_model_getObjectMaterial(int index, int object) { return modelStack[index].objects[object].materialRef; }
+
+/*
+ * renderer_model_getBounds
+ */
+void renderer_model_getBounds(int index, vec3_t mins, vec3_t maxs)
+{
+	VectorCopy(modelStack[index].mins, mins);
+	VectorCopy(modelStack[index].maxs, maxs);
+}
+
+int renderer_model_getNumObjects(int index) { return modelStack[index].numObjects; }
+int renderer_model_getNumModels() { return modelPtr; }
+const char *renderer_model_getName(int index) { return modelStack[index].name; }
+
+/*
+ * renderer_model_getObjectBounds
+ */
+void renderer_model_getObjectBounds(int index, int object, vec3_t mins, vec3_t maxs)
+{
+	VectorCopy(modelStack[index].objects[object].mins, mins);
+	VectorCopy(modelStack[index].objects[object].maxs, maxs);
+}
+
+/*
+ * renderer_model_setOccluder
+ * Flags a model as an occluder. The first time, its triangles are copied
+ * out into the flat arrays the occlusion rasterizer wants.
+ */
+void renderer_model_setOccluder(int index, eboolean occluder)
+{
+	int 				i, j, base, n;
+	ase_model_t 		*model;
+	ase_mesh_t			*mesh;
+
+	model = &(modelStack[index]);
+	model->occluder = occluder;
+
+	if(!occluder || model->occVerts != NULL)
+		return;
+
+	for(i = 0; i < model->numObjects; i++)
+	{
+		model->occNumVerts += model->objects[i].mesh.numVertex;
+		model->occNumTris  += model->objects[i].mesh.numFaces;
+	}
+
+	model->occVerts	  = (float *)malloc(sizeof(float) * 3 * model->occNumVerts);
+	model->occIndices = (int *)malloc(sizeof(int) * 3 * model->occNumTris);
+
+	base = n = 0;
+
+	for(i = 0; i < model->numObjects; i++)
+	{
+		mesh = &(model->objects[i].mesh);
+
+		for(j = 0; j < mesh->numVertex; j++)
+			memcpy(&model->occVerts[(base + j) * 3], mesh->vertexList[j].coords, sizeof(vec3_t));
+
+		for(j = 0; j < mesh->numFaces; j++)
+		{
+			model->occIndices[n++] = base + mesh->faceList[j].A;
+			model->occIndices[n++] = base + mesh->faceList[j].B;
+			model->occIndices[n++] = base + mesh->faceList[j].C;
+		}
+
+		base += mesh->numVertex;
+	}
+}
+
+/*
+ * renderer_model_drawOccluder
+ * Rasterizes the model into the occlusion buffer, if it is an occluder.
+ */
+void renderer_model_drawOccluder(int index, const float *mvp)
+{
+	ase_model_t *model = &(modelStack[index]);
+
+	if(!model->occluder)
+		return;
+
+	renderer_occ_drawMesh(mvp, model->occVerts, model->occNumVerts,
+			model->occIndices, model->occNumTris);
+}
+
 /*
 ===========================================================================
 Debugging
@@ -0,0 +1,418 @@
+/*
+===========================================================================
+File:		renderer_occlusion.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Software occlusion culling. Occluder triangles are rasterized
+			into a small CPU depth buffer, and bounding boxes are tested
+			against it before anything is handed to GL. Everything in
+			here is plain CPU code, so it works (and gives the same
+			answers) without a GPU. Not thread safe, only ever use it
+			from one recorder.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_cpuinfo.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+#include "headers/simd.h"
+
+#include "headers/renderer_occlusion.h"
+
+#ifdef SIMD_X86
+#include <xmmintrin.h>
+#endif
+
+typedef struct
+{
+	//Edge functions, inside when all three are >= 0
+	float	A[3], B[3], C[3];
+	//Depth plane, z = zA*x + zB*y + zC
+	float	zA, zB, zC;
+	int		minX, maxX, minY, maxY;
+}
+occTri_t;
+
+typedef void     (*occRasterFunc_t)(const occTri_t *tri);
+typedef eboolean (*occTestFunc_t)(int minX, int maxX, int minY, int maxY, float z);
+
+static void     occ_rasterScalar(const occTri_t *tri);
+static eboolean occ_testScalar(int minX, int maxX, int minY, int maxY, float z);
+
+#ifdef SIMD_X86
+static void     occ_rasterSSE(const occTri_t *tri);
+static eboolean occ_testSSE(int minX, int maxX, int minY, int maxY, float z);
+#endif
+
+static float			depthBuffer[OCC_WIDTH * OCC_HEIGHT];
+static occRasterFunc_t	occ_raster	= occ_rasterScalar;
+static occTestFunc_t	occ_test	= occ_testScalar;
+
+static float	*clipVerts		  = NULL;
+static int		clipVertsAllocated = 0;
+static int		numTested, numCulled;
+
+/*
+ * renderer_occ_init
+ * Picks the vector or scalar code paths. Both produce the same buffer.
+ */
+void renderer_occ_init()
+{
+#ifdef SIMD_X86
+	if(SDL_HasSSE())
+	{
+		occ_raster = occ_rasterSSE;
+		occ_test   = occ_testSSE;
+	}
+#endif
+
+	renderer_occ_clear();
+}
+
+/*
+ * renderer_occ_clear
+ * Resets the buffer to the far plane. Call once per frame before drawing
+ * occluders.
+ */
+void renderer_occ_clear()
+{
+	int i;
+
+	for(i = 0; i < OCC_WIDTH * OCC_HEIGHT; i++)
+		depthBuffer[i] = 1.0;
+
+	numTested = numCulled = 0;
+}
+
+const float * renderer_occ_getDepth() { return depthBuffer; }
+
+void renderer_occ_getStats(int *tested, int *culled)
+{
+	*tested = numTested;
+	*culled = numCulled;
+}
+
+/*
+ * occ_transform
+ * Object space to clip space.
+ */
+static void occ_transform(const float *m, const float *in, float *out)
+{
+	out[0] = m[0]*in[0] + m[4]*in[1] + m[8]*in[2]  + m[12];
+	out[1] = m[1]*in[0] + m[5]*in[1] + m[9]*in[2]  + m[13];
+	out[2] = m[2]*in[0] + m[6]*in[1] + m[10]*in[2] + m[14];
+	out[3] = m[3]*in[0] + m[7]*in[1] + m[11]*in[2] + m[15];
+}
+
+/*
+ * occ_toScreen
+ * Clip space to buffer coordinates, depth mapped to [0, 1].
+ */
+static void occ_toScreen(const float *clip, float *screen)
+{
+	float iw = 1.0f / clip[3];
+
+	screen[_X] = (clip[0] * iw * 0.5f + 0.5f) * OCC_WIDTH;
+	screen[_Y] = (clip[1] * iw * 0.5f + 0.5f) * OCC_HEIGHT;
+	screen[_Z] =  clip[2] * iw * 0.5f + 0.5f;
+}
+
+/*
+ * occ_setupTriangle
+ * Returns efalse if there is nothing to rasterize.
+ */
+static eboolean occ_setupTriangle(const float *v0, const float *v1, const float *v2, occTri_t *tri)
+{
+	const float	*v[3];
+	const float	*tmp;
+	float		area, invArea, minX, maxX, minY, maxY;
+	int			i, j, k;
+
+	v[0] = v0; v[1] = v1; v[2] = v2;
+
+	area = (v[1][_X] - v[0][_X]) * (v[2][_Y] - v[0][_Y]) -
+		   (v[1][_Y] - v[0][_Y]) * (v[2][_X] - v[0][_X]);
+
+	//Occluders are rasterized two-sided, just fix up the winding
+	if(area < 0)
+	{
+		tmp = v[1]; v[1] = v[2]; v[2] = tmp;
+		area = -area;
+	}
+
+	if(area < 1e-6f)
+		return efalse;
+
+	minX = maxX = v[0][_X];
+	minY = maxY = v[0][_Y];
+
+	for(i = 1; i < 3; i++)
+	{
+		if(v[i][_X] < minX) minX = v[i][_X];
+		if(v[i][_X] > maxX) maxX = v[i][_X];
+		if(v[i][_Y] < minY) minY = v[i][_Y];
+		if(v[i][_Y] > maxY) maxY = v[i][_Y];
+	}
+
+	tri->minX = (int)floor(minX); if(tri->minX < 0) tri->minX = 0;
+	tri->minY = (int)floor(minY); if(tri->minY < 0) tri->minY = 0;
+	tri->maxX = (int)ceil(maxX);  if(tri->maxX > OCC_WIDTH-1)  tri->maxX = OCC_WIDTH-1;
+	tri->maxY = (int)ceil(maxY);  if(tri->maxY > OCC_HEIGHT-1) tri->maxY = OCC_HEIGHT-1;
+
+	if(tri->minX > tri->maxX || tri->minY > tri->maxY)
+		return efalse;
+
+	//Edge i runs from v[j] to v[k], and is opposite of v[i]
+	for(i = 0; i < 3; i++)
+	{
+		j = (i + 1) % 3;
+		k = (i + 2) % 3;
+
+		tri->A[i] = v[j][_Y] - v[k][_Y];
+		tri->B[i] = v[k][_X] - v[j][_X];
+		tri->C[i] = -(tri->A[i] * v[j][_X] + tri->B[i] * v[j][_Y]);
+	}
+
+	//Barycentric weights are the edge functions over the area
+	invArea = 1.0f / area;
+
+	tri->zA = (tri->A[0]*v[0][_Z] + tri->A[1]*v[1][_Z] + tri->A[2]*v[2][_Z]) * invArea;
+	tri->zB = (tri->B[0]*v[0][_Z] + tri->B[1]*v[1][_Z] + tri->B[2]*v[2][_Z]) * invArea;
+	tri->zC = (tri->C[0]*v[0][_Z] + tri->C[1]*v[1][_Z] + tri->C[2]*v[2][_Z]) * invArea;
+
+	return etrue;
+}
+
+/*
+ * renderer_occ_drawMesh
+ * verts are packed x, y, z triples, indices are three per triangle.
+ * Triangles crossing the near plane are skipped rather than clipped:
+ * leaving out an occluder can only make the test more conservative.
+ */
+void renderer_occ_drawMesh(const float *mvp, const float *verts, int numVerts,
+		const int *indices, int numTris)
+{
+	int			i, j;
+	float		*clip, screen[3][3];
+	eboolean	behind;
+	occTri_t	tri;
+
+	if(numVerts > clipVertsAllocated)
+	{
+		clipVertsAllocated = numVerts;
+		clipVerts = (float *)realloc(clipVerts, sizeof(float) * 4 * clipVertsAllocated);
+	}
+
+	for(i = 0; i < numVerts; i++)
+		occ_transform(mvp, &verts[i*3], &clipVerts[i*4]);
+
+	for(i = 0; i < numTris; i++)
+	{
+		behind = efalse;
+
+		for(j = 0; j < 3; j++)
+		{
+			clip = &clipVerts[indices[i*3+j] * 4];
+
+			if(clip[3] <= 0.0f || clip[2] < -clip[3])
+			{
+				behind = etrue;
+				break;
+			}
+
+			occ_toScreen(clip, screen[j]);
+		}
+
+		if(behind)
+			continue;
+
+		if(occ_setupTriangle(screen[0], screen[1], screen[2], &tri))
+			occ_raster(&tri);
+	}
+}
+
+/*
+ * renderer_occ_testBox
+ * Returns etrue if any part of the box might be visible. The box is
+ * reduced to its screen rectangle at its nearest depth, so the answer
+ * errs on the side of visible.
+ */
+eboolean renderer_occ_testBox(const float *mvp, const vec3_t mins, const vec3_t maxs)
+{
+	int		i, minX, maxX, minY, maxY;
+	float	corner[3], clip[4], screen[3];
+	float	sMinX, sMaxX, sMinY, sMaxY, sMinZ;
+
+	numTested++;
+
+	sMinX = sMinY = sMinZ =  1e30f;
+	sMaxX = sMaxY		  = -1e30f;
+
+	for(i = 0; i < 8; i++)
+	{
+		corner[_X] = (i & 1) ? maxs[_X] : mins[_X];
+		corner[_Y] = (i & 2) ? maxs[_Y] : mins[_Y];
+		corner[_Z] = (i & 4) ? maxs[_Z] : mins[_Z];
+
+		occ_transform(mvp, corner, clip);
+
+		//Crosses the near plane, assume it can be seen
+		if(clip[3] <= 0.0f || clip[2] < -clip[3])
+			return etrue;
+
+		occ_toScreen(clip, screen);
+
+		if(screen[_X] < sMinX) sMinX = screen[_X];
+		if(screen[_X] > sMaxX) sMaxX = screen[_X];
+		if(screen[_Y] < sMinY) sMinY = screen[_Y];
+		if(screen[_Y] > sMaxY) sMaxY = screen[_Y];
+		if(screen[_Z] < sMinZ) sMinZ = screen[_Z];
+	}
+
+	//Completely off screen or past the far plane
+	if(sMaxX < 0 || sMaxY < 0 || sMinX > OCC_WIDTH || sMinY > OCC_HEIGHT || sMinZ > 1.0f)
+	{
+		numCulled++;
+		return efalse;
+	}
+
+	minX = (int)floor(sMinX); if(minX < 0) minX = 0;
+	minY = (int)floor(sMinY); if(minY < 0) minY = 0;
+	maxX = (int)floor(sMaxX); if(maxX > OCC_WIDTH-1)  maxX = OCC_WIDTH-1;
+	maxY = (int)floor(sMaxY); if(maxY > OCC_HEIGHT-1) maxY = OCC_HEIGHT-1;
+
+	if(occ_test(minX, maxX, minY, maxY, sMinZ))
+		return etrue;
+
+	numCulled++;
+	return efalse;
+}
+
+/*
+===========================================================================
+Scalar
+===========================================================================
+*/
+
+static void occ_rasterScalar(const occTri_t *tri)
+{
+	int		x, y;
+	float	px, py, z, *row;
+
+	for(y = tri->minY; y <= tri->maxY; y++)
+	{
+		py  = y + 0.5f;
+		row = &depthBuffer[y * OCC_WIDTH];
+
+		for(x = tri->minX; x <= tri->maxX; x++)
+		{
+			px = x + 0.5f;
+
+			if(tri->A[0]*px + tri->B[0]*py + tri->C[0] < 0 ||
+			   tri->A[1]*px + tri->B[1]*py + tri->C[1] < 0 ||
+			   tri->A[2]*px + tri->B[2]*py + tri->C[2] < 0)
+				continue;
+
+			z = tri->zA*px + tri->zB*py + tri->zC;
+
+			if(z < row[x])
+				row[x] = z;
+		}
+	}
+}
+
+static eboolean occ_testScalar(int minX, int maxX, int minY, int maxY, float z)
+{
+	int x, y;
+
+	for(y = minY; y <= maxY; y++)
+		for(x = minX; x <= maxX; x++)
+			if(depthBuffer[y * OCC_WIDTH + x] >= z)
+				return etrue;
+
+	return efalse;
+}
+
+/*
+===========================================================================
+SSE
+===========================================================================
+*/
+
+#ifdef SIMD_X86
+
+/*
+ * occ_rasterSSE
+ * Four pixels per step. Starts on a multiple of 4 so a step never leaves
+ * the row, pixels outside the triangle's bounds fail the edge tests anyway.
+ */
+SIMD_TARGET("sse") static void occ_rasterSSE(const occTri_t *tri)
+{
+	int		x, y;
+	float	*row;
+	__m128	px, py, offsets, e0, e1, e2, z, old, mask, zero;
+
+	offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	zero	= _mm_setzero_ps();
+
+	for(y = tri->minY; y <= tri->maxY; y++)
+	{
+		py  = _mm_set1_ps(y + 0.5f);
+		row = &depthBuffer[y * OCC_WIDTH];
+
+		for(x = tri->minX & ~3; x <= tri->maxX; x += 4)
+		{
+			px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+
+			e0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->A[0]), px),
+					_mm_mul_ps(_mm_set1_ps(tri->B[0]), py)), _mm_set1_ps(tri->C[0]));
+			e1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->A[1]), px),
+					_mm_mul_ps(_mm_set1_ps(tri->B[1]), py)), _mm_set1_ps(tri->C[1]));
+			e2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->A[2]), px),
+					_mm_mul_ps(_mm_set1_ps(tri->B[2]), py)), _mm_set1_ps(tri->C[2]));
+
+			mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+					_mm_cmpge_ps(e2, zero));
+
+			if(_mm_movemask_ps(mask) == 0)
+				continue;
+
+			z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri->zA), px),
+					_mm_mul_ps(_mm_set1_ps(tri->zB), py)), _mm_set1_ps(tri->zC));
+
+			old  = _mm_loadu_ps(&row[x]);
+			z	 = _mm_min_ps(z, old);
+			_mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, old)));
+		}
+	}
+}
+
+SIMD_TARGET("sse") static eboolean occ_testSSE(int minX, int maxX, int minY, int maxY, float z)
+{
+	int		x, y;
+	__m128	vz, lanes, lo, hi, inRange, px;
+
+	vz	  = _mm_set1_ps(z);
+	lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	lo	  = _mm_set1_ps((float)minX);
+	hi	  = _mm_set1_ps((float)maxX);
+
+	for(y = minY; y <= maxY; y++)
+	{
+		for(x = minX & ~3; x <= maxX; x += 4)
+		{
+			px		= _mm_add_ps(_mm_set1_ps((float)x), lanes);
+			inRange = _mm_and_ps(_mm_cmpge_ps(px, lo), _mm_cmple_ps(px, hi));
+
+			if(_mm_movemask_ps(_mm_and_ps(inRange,
+					_mm_cmpge_ps(_mm_loadu_ps(&depthBuffer[y * OCC_WIDTH + x]), vz))))
+				return etrue;
+		}
+	}
+
+	return efalse;
+}
+
+#endif
@@ -0,0 +1,259 @@
+/*
+===========================================================================
+File:		renderer_scale.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Dynamic resolution. The scene is drawn into an offscreen target
+			big enough for the largest scale, using only as much of it as
+			the current scale calls for, and then stretched over the
+			window. Changing the scale is just a different viewport, the
+			target never gets reallocated.
+
+			Fill rate goes with the pixel count, so the scale moves by the
+			square root of how far the smoothed frame time is off target.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_scale.h"
+
+//Render sizes are rounded to this many pixels, so small changes in the
+//scale don't show up as shimmering
+#define SCALE_GRANULARITY 8
+
+static GLuint	framebuffer = 0, colorTexture = 0, depthStencil = 0;
+static int		winWidth, winHeight, targetWidth, targetHeight;
+static int		sceneWidth, sceneHeight;
+static float	minScale, maxScale, targetMs;
+static float	scale, smoothedMs;
+static int		settleFrames;
+static eboolean	enabled = efalse, drawingScene = efalse;
+
+/*
+ * renderer_scale_sceneSize
+ */
+static int renderer_scale_sceneSize(int size)
+{
+	size = (int)(size * scale + 0.5) / SCALE_GRANULARITY * SCALE_GRANULARITY;
+
+	return size < SCALE_GRANULARITY ? SCALE_GRANULARITY : size;
+}
+
+/*
+ * renderer_scale_init
+ * Scales are fractions of the window size in each direction. Frame time
+ * target in milliseconds. Returns efalse if there's no render to texture.
+ */
+eboolean renderer_scale_init(int width, int height, float minS, float maxS, float target)
+{
+	GLenum status;
+
+	if(!glConfig.framebufferObject)
+	{
+		printf("Dynamic resolution: no framebuffer objects.\n");
+		return efalse;
+	}
+
+	winWidth	= width;
+	winHeight	= height;
+	minScale	= minS;
+	maxScale	= maxS > minS ? maxS : minS;
+	targetMs	= target;
+	scale		= maxScale;
+	smoothedMs	= target;
+
+	targetWidth	 = (int)(width  * maxScale + 0.5);
+	targetHeight = (int)(height * maxScale + 0.5);
+
+	glGenTextures(1, &colorTexture);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, targetWidth, targetHeight,
+			0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	//Stencil is for overdraw counting
+	qglGenRenderbuffers(1, &depthStencil);
+	qglBindRenderbuffer(GL_RENDERBUFFER_EXT, depthStencil);
+	qglRenderbufferStorage(GL_RENDERBUFFER_EXT, GL_DEPTH24_STENCIL8, targetWidth, targetHeight);
+	qglBindRenderbuffer(GL_RENDERBUFFER_EXT, 0);
+
+	qglGenFramebuffers(1, &framebuffer);
+	qglBindFramebuffer(GL_FRAMEBUFFER_EXT, framebuffer);
+
+	qglFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, colorTexture, 0);
+	qglFramebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, depthStencil);
+	qglFramebufferRenderbuffer(GL_FRAMEBUFFER_EXT, GL_STENCIL_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, depthStencil);
+
+	status = qglCheckFramebufferStatus(GL_FRAMEBUFFER_EXT);
+	qglBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
+
+	if(status != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		printf("Dynamic resolution: framebuffer incomplete (0x%x).\n", status);
+		renderer_scale_shutdown();
+		return efalse;
+	}
+
+	printf("Dynamic resolution: %dx%d target, scale %.2f to %.2f, aiming for %.1f ms\n",
+			targetWidth, targetHeight, minScale, maxScale, targetMs);
+	return etrue;
+}
+
+/*
+ * renderer_scale_shutdown
+ */
+void renderer_scale_shutdown()
+{
+	if(framebuffer)
+		qglDeleteFramebuffers(1, &framebuffer);
+	if(depthStencil)
+		qglDeleteRenderbuffers(1, &depthStencil);
+	if(colorTexture)
+		glDeleteTextures(1, &colorTexture);
+
+	framebuffer = depthStencil = colorTexture = 0;
+	enabled = efalse;
+}
+
+/*
+ * renderer_scale_setEnabled
+ * Does nothing without a successful renderer_scale_init.
+ */
+void renderer_scale_setEnabled(eboolean enable)
+{
+	enabled = enable && framebuffer;
+}
+
+/*
+ * renderer_scale_update
+ * Feeds in how long the last frame took.
+ */
+void renderer_scale_update(float frameMs)
+{
+	float desired;
+
+	if(!enabled)
+		return;
+
+	smoothedMs = smoothedMs * (1.0 - SCALE_SMOOTHING) + frameMs * SCALE_SMOOTHING;
+
+	if(settleFrames > 0)
+	{
+		settleFrames--;
+		return;
+	}
+
+	if(smoothedMs > targetMs * (1.0 - SCALE_TOLERANCE) &&
+	   smoothedMs < targetMs * (1.0 + SCALE_TOLERANCE))
+		return;
+
+	desired = scale * sqrt(targetMs / smoothedMs);
+
+	if(desired < minScale)
+		desired = minScale;
+	if(desired > maxScale)
+		desired = maxScale;
+
+	//Only counts as a change if the render size actually moves
+	if(fabs(desired - scale) * winWidth < SCALE_GRANULARITY / 2)
+		return;
+
+	scale		 = desired;
+	settleFrames = SCALE_SETTLE_FRAMES;
+}
+
+/*
+ * renderer_scale_getScale
+ * 1.0 while disabled.
+ */
+float renderer_scale_getScale()
+{
+	return enabled ? scale : 1.0;
+}
+
+/*
+ * renderer_scale_beginScene
+ * Points everything after it at the offscreen target.
+ */
+void renderer_scale_beginScene()
+{
+	if(!enabled)
+		return;
+
+	sceneWidth	= renderer_scale_sceneSize(winWidth);
+	sceneHeight	= renderer_scale_sceneSize(winHeight);
+
+	qglBindFramebuffer(GL_FRAMEBUFFER_EXT, framebuffer);
+	glViewport(0, 0, sceneWidth, sceneHeight);
+
+	drawingScene = etrue;
+}
+
+/*
+ * renderer_scale_endScene
+ * Stretches the scene over the whole window. Whatever comes after this is
+ * drawn at window resolution.
+ */
+void renderer_scale_endScene()
+{
+	float s, t;
+
+	if(!drawingScene)
+		return;
+
+	drawingScene = efalse;
+
+	qglBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
+	glViewport(0, 0, winWidth, winHeight);
+
+	//Unless the scene fills the whole target, stop half a texel short of
+	//its far edges so bilinear filtering never reaches past what was
+	//drawn. The near edges are already clamped.
+	s = (sceneWidth  < targetWidth  ? sceneWidth  - 0.5 : sceneWidth)  / (float)targetWidth;
+	t = (sceneHeight < targetHeight ? sceneHeight - 0.5 : sceneHeight) / (float)targetHeight;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_STENCIL_TEST);
+	glEnable(GL_TEXTURE_2D);
+
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glBegin(GL_QUADS);
+		glTexCoord2f(0.0, 0.0);	glVertex2f(-1.0, -1.0);
+		glTexCoord2f(s,   0.0);	glVertex2f( 1.0, -1.0);
+		glTexCoord2f(s,   t);	glVertex2f( 1.0,  1.0);
+		glTexCoord2f(0.0, t);	glVertex2f(-1.0,  1.0);
+	glEnd();
+
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	glPopAttrib();
+}
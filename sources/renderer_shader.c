@@ -0,0 +1,451 @@
+/*
+===========================================================================
+File:		renderer_shader.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		One uber-shader, compiled once for every combination of the
+			SHADER_ feature bits by #defining them ahead of the source.
+
+			Uniforms live in three uniform buffers:
+				frame		projection and light, rewritten when they change
+				draw		every modelview matrix in the frame, uploaded
+							once per frame, one aligned slot each
+				material	every material, uploaded once after loading
+
+			so switching matrices or materials is a glBindBufferRange.
+			Geometry still comes in through the old built-in attributes,
+			which keeps display lists and vertex arrays working as is.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_materials.h"
+#include "headers/renderer_glext.h"
+#include "headers/renderer_shader.h"
+
+//Uniform buffer binding points
+#define BINDING_FRAME		0
+#define BINDING_DRAW		1
+#define BINDING_MATERIAL	2
+
+//Size of each block, std140
+#define FRAME_BLOCK_SIZE	(sizeof(float) * 20)
+#define DRAW_BLOCK_SIZE		(sizeof(float) * 16)
+#define MATERIAL_BLOCK_SIZE	(sizeof(float) * 16)
+
+static const char *shaderVersion = "#version 140\n";
+
+static const char *vertexSource =
+	"layout(std140) uniform frame\n"
+	"{\n"
+	"	mat4 projection;\n"
+	"	vec4 lightDir;\n"
+	"};\n"
+	"\n"
+	"layout(std140) uniform draw\n"
+	"{\n"
+	"	mat4 modelview;\n"
+	"};\n"
+	"\n"
+	"out vec2 st;\n"
+	"out vec4 vertexColor;\n"
+	"out vec3 normal;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	gl_Position = projection * (modelview * gl_Vertex);\n"
+	"\n"
+	"#ifdef TEXTURED\n"
+	"	st = gl_MultiTexCoord0.st;\n"
+	"#endif\n"
+	"#ifdef VERTEX_COLOR\n"
+	"	vertexColor = gl_Color;\n"
+	"#endif\n"
+	"#ifdef LIT\n"
+	"	normal = mat3(modelview) * gl_Normal;\n"
+	"#endif\n"
+	"}\n";
+
+static const char *fragmentSource =
+	"layout(std140) uniform frame\n"
+	"{\n"
+	"	mat4 projection;\n"
+	"	vec4 lightDir;\n"
+	"};\n"
+	"\n"
+	"layout(std140) uniform material\n"
+	"{\n"
+	"	vec4 ambient;\n"
+	"	vec4 diffuse;\n"
+	"	vec4 specular;\n"
+	"	vec4 color;\n"
+	"};\n"
+	"\n"
+	"uniform sampler2D image;\n"
+	"\n"
+	"in vec2 st;\n"
+	"in vec4 vertexColor;\n"
+	"in vec3 normal;\n"
+	"\n"
+	"out vec4 fragColor;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	vec4 c = color;\n"
+	"\n"
+	"#ifdef TEXTURED\n"
+	"	c *= texture(image, st);\n"
+	"#endif\n"
+	"#ifdef VERTEX_COLOR\n"
+	"	c *= vertexColor;\n"
+	"#endif\n"
+	"#ifdef LIT\n"
+	"	vec3 n = normalize(normal);\n"
+	"	vec3 h = normalize(lightDir.xyz + vec3(0.0, 0.0, 1.0));\n"
+	"\n"
+	"	c.rgb = c.rgb * (ambient.rgb + diffuse.rgb * max(dot(n, lightDir.xyz), 0.0)) +\n"
+	"			specular.rgb * pow(max(dot(n, h), 0.0), specular.w);\n"
+	"#endif\n"
+	"#ifndef ALPHA\n"
+	"	c.a = 1.0;\n"
+	"#endif\n"
+	"\n"
+	"	fragColor = c;\n"
+	"}\n";
+
+static GLuint	programs[MAX_SHADER_VARIANTS];
+static GLuint	frameBuffer = 0, drawBuffer = 0, materialBuffer = 0;
+static int		drawStride, materialStride, numMaterialSlots;
+
+//Matrices get written here with the uniform buffer's stride
+static byte		*drawStaging = NULL;
+
+//Light in view space, coming from above and behind the camera
+static const vec3_t lightDir = { 0.3, 0.8, 0.52 };
+
+/*
+ * renderer_shader_align
+ */
+static int renderer_shader_align(int size, int alignment)
+{
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+/*
+ * renderer_shader_compile
+ * Returns 0 and prints the log if compiling fails.
+ */
+static GLuint renderer_shader_compile(GLenum type, const char *defines, const char *source)
+{
+	const GLchar	*strings[3];
+	GLchar			log[1024];
+	GLuint			shader;
+	GLint			status;
+
+	strings[0] = shaderVersion;
+	strings[1] = defines;
+	strings[2] = source;
+
+	shader = qglCreateShader(type);
+	qglShaderSource(shader, 3, strings, NULL);
+	qglCompileShader(shader);
+
+	qglGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if(!status)
+	{
+		qglGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("Shader: compiling failed.\n%s", log);
+		qglDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+/*
+ * renderer_shader_link
+ * Builds the program for one feature set, with its uniform blocks hooked
+ * up to the fixed binding points.
+ */
+static GLuint renderer_shader_link(int features)
+{
+	char	defines[256];
+	GLchar	log[1024];
+	GLuint	vertex, fragment, program, block;
+	GLint	status;
+
+	defines[0] = '\0';
+	if(features & SHADER_TEXTURED)
+		strcat(defines, "#define TEXTURED\n");
+	if(features & SHADER_VERTEX_COLOR)
+		strcat(defines, "#define VERTEX_COLOR\n");
+	if(features & SHADER_ALPHA)
+		strcat(defines, "#define ALPHA\n");
+	if(features & SHADER_LIT)
+		strcat(defines, "#define LIT\n");
+
+	vertex	 = renderer_shader_compile(GL_VERTEX_SHADER, defines, vertexSource);
+	fragment = renderer_shader_compile(GL_FRAGMENT_SHADER, defines, fragmentSource);
+
+	if(!vertex || !fragment)
+	{
+		if(vertex)
+			qglDeleteShader(vertex);
+		if(fragment)
+			qglDeleteShader(fragment);
+		return 0;
+	}
+
+	program = qglCreateProgram();
+	qglAttachShader(program, vertex);
+	qglAttachShader(program, fragment);
+	qglLinkProgram(program);
+
+	//The program keeps them alive for as long as it needs them
+	qglDeleteShader(vertex);
+	qglDeleteShader(fragment);
+
+	qglGetProgramiv(program, GL_LINK_STATUS, &status);
+	if(!status)
+	{
+		qglGetProgramInfoLog(program, sizeof(log), NULL, log);
+		printf("Shader: linking variant %d failed.\n%s", features, log);
+		qglDeleteProgram(program);
+		return 0;
+	}
+
+	//Blocks the compiler stripped out come back as GL_INVALID_INDEX
+	if((block = qglGetUniformBlockIndex(program, "frame")) != GL_INVALID_INDEX)
+		qglUniformBlockBinding(program, block, BINDING_FRAME);
+	if((block = qglGetUniformBlockIndex(program, "draw")) != GL_INVALID_INDEX)
+		qglUniformBlockBinding(program, block, BINDING_DRAW);
+	if((block = qglGetUniformBlockIndex(program, "material")) != GL_INVALID_INDEX)
+		qglUniformBlockBinding(program, block, BINDING_MATERIAL);
+
+	return program;
+}
+
+/*
+ * renderer_shader_init
+ * Compiles every variant up front so nothing stalls mid-frame. Call after
+ * renderer_glext_init. Returns efalse if shaders can't be used, and the
+ * fixed-function path is all there is.
+ */
+eboolean renderer_shader_init()
+{
+	GLint	alignment;
+	int		i;
+
+	memset(programs, 0, sizeof(programs));
+
+	if(!glConfig.shaders)
+		return efalse;
+
+	for(i = 0; i < MAX_SHADER_VARIANTS; i++)
+	{
+		programs[i] = renderer_shader_link(i);
+
+		if(!programs[i])
+		{
+			renderer_shader_shutdown();
+			return efalse;
+		}
+	}
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if(alignment < 1)
+		alignment = 256;
+
+	drawStride		= renderer_shader_align(DRAW_BLOCK_SIZE, alignment);
+	materialStride	= renderer_shader_align(MATERIAL_BLOCK_SIZE, alignment);
+	drawStaging		= (byte *)malloc(drawStride * MAX_SHADER_MATRICES);
+
+	qglGenBuffers(1, &frameBuffer);
+	qglGenBuffers(1, &drawBuffer);
+	qglGenBuffers(1, &materialBuffer);
+
+	qglBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+	qglBufferData(GL_UNIFORM_BUFFER, FRAME_BLOCK_SIZE, NULL, GL_DYNAMIC_DRAW);
+	qglBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	qglBindBufferRange(GL_UNIFORM_BUFFER, BINDING_FRAME, frameBuffer, 0, FRAME_BLOCK_SIZE);
+
+	printf("Shaders: %d variants, uniform buffer alignment %d\n", MAX_SHADER_VARIANTS, alignment);
+	return etrue;
+}
+
+/*
+ * renderer_shader_shutdown
+ */
+void renderer_shader_shutdown()
+{
+	int i;
+
+	for(i = 0; i < MAX_SHADER_VARIANTS; i++)
+		if(programs[i])
+			qglDeleteProgram(programs[i]);
+
+	if(frameBuffer)
+		qglDeleteBuffers(1, &frameBuffer);
+	if(drawBuffer)
+		qglDeleteBuffers(1, &drawBuffer);
+	if(materialBuffer)
+		qglDeleteBuffers(1, &materialBuffer);
+
+	free(drawStaging);
+
+	memset(programs, 0, sizeof(programs));
+	frameBuffer = drawBuffer = materialBuffer = 0;
+	drawStaging = NULL;
+}
+
+/*
+ * renderer_shader_buildMaterials
+ * Uploads every material loaded so far, plus a plain white one at the end
+ * for SHADER_NO_MATERIAL. Call once all the models are in.
+ */
+void renderer_shader_buildMaterials()
+{
+	vec3_t	ambient, diffuse, specular;
+	float	shine, *block;
+	byte	*data;
+	int		i, numMaterials;
+
+	if(!materialBuffer)
+		return;
+
+	numMaterials	 = renderer_img_getNumMaterials();
+	numMaterialSlots = numMaterials + 1;
+
+	data = (byte *)calloc(numMaterialSlots, materialStride);
+
+	for(i = 0; i < numMaterialSlots; i++)
+	{
+		block = (float *)(data + i * materialStride);
+
+		if(i < numMaterials)
+		{
+			renderer_img_getMatLighting(i, ambient, diffuse, specular, &shine);
+
+			memcpy(block,	  ambient,  sizeof(vec3_t));
+			memcpy(block + 4, diffuse,  sizeof(vec3_t));
+			memcpy(block + 8, specular, sizeof(vec3_t));
+
+			//Shine is 0 to 1 in the ASE files
+			block[11] = shine * 128.0 > 1.0 ? shine * 128.0 : 1.0;
+			block[15] = 1.0 - renderer_img_getMatTransparency(i);
+		}
+		else
+		{
+			block[0] = block[1] = block[2] = 1.0;
+			block[11] = 1.0;
+			block[15] = 1.0;
+		}
+
+		block[12] = block[13] = block[14] = 1.0;
+	}
+
+	qglBindBuffer(GL_UNIFORM_BUFFER, materialBuffer);
+	qglBufferData(GL_UNIFORM_BUFFER, numMaterialSlots * materialStride, data, GL_STATIC_DRAW);
+	qglBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	free(data);
+}
+
+/*
+ * renderer_shader_setProjection
+ */
+void renderer_shader_setProjection(const float *projection)
+{
+	float block[20];
+
+	if(!frameBuffer)
+		return;
+
+	memcpy(block, projection, sizeof(float) * 16);
+	memcpy(block + 16, lightDir, sizeof(vec3_t));
+	block[19] = 0.0;
+
+	qglBindBuffer(GL_UNIFORM_BUFFER, frameBuffer);
+	qglBufferSubData(GL_UNIFORM_BUFFER, 0, FRAME_BLOCK_SIZE, block);
+	qglBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/*
+ * renderer_shader_beginMatrices
+ * Returns where to write this frame's modelview matrices, 16 floats each
+ * and back to back. Follow it with renderer_shader_endMatrices.
+ */
+float * renderer_shader_beginMatrices(int numMatrices)
+{
+	if(!drawStaging || numMatrices > MAX_SHADER_MATRICES)
+		return NULL;
+
+	return (float *)drawStaging;
+}
+
+/*
+ * renderer_shader_endMatrices
+ * Spreads the matrices out to the buffer's alignment, back to front so
+ * none get stepped on, and uploads them all at once.
+ */
+void renderer_shader_endMatrices(int numMatrices)
+{
+	int i;
+
+	if(!drawStaging || numMatrices <= 0)
+		return;
+
+	for(i = numMatrices - 1; i > 0; i--)
+		memmove(drawStaging + i * drawStride, drawStaging + i * DRAW_BLOCK_SIZE, DRAW_BLOCK_SIZE);
+
+	qglBindBuffer(GL_UNIFORM_BUFFER, drawBuffer);
+	qglBufferData(GL_UNIFORM_BUFFER, numMatrices * drawStride, drawStaging, GL_STREAM_DRAW);
+	qglBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+/*
+ * renderer_shader_bind
+ */
+void renderer_shader_bind(int features)
+{
+	qglUseProgram(programs[features & (MAX_SHADER_VARIANTS - 1)]);
+}
+
+/*
+ * renderer_shader_unbind
+ * Back to fixed function.
+ */
+void renderer_shader_unbind()
+{
+	qglUseProgram(0);
+}
+
+/*
+ * renderer_shader_setMatrix
+ * slot is the matrix's index in this frame's upload.
+ */
+void renderer_shader_setMatrix(int slot)
+{
+	qglBindBufferRange(GL_UNIFORM_BUFFER, BINDING_DRAW, drawBuffer, slot * drawStride, DRAW_BLOCK_SIZE);
+}
+
+/*
+ * renderer_shader_setMaterial
+ */
+void renderer_shader_setMaterial(int material)
+{
+	if(!numMaterialSlots)
+		return;
+
+	if(material < 0 || material >= numMaterialSlots)
+		material = numMaterialSlots - 1;
+
+	qglBindBufferRange(GL_UNIFORM_BUFFER, BINDING_MATERIAL, materialBuffer,
+			material * materialStride, MATERIAL_BLOCK_SIZE);
+}
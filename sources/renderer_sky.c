@@ -0,0 +1,137 @@
+/*
+===========================================================================
+File:		renderer_sky.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Cube map sky. It is drawn after all of the opaque geometry,
+			pinned to the far plane with glDepthRange, so any pixel that is
+			already covered fails the depth test and never gets shaded.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_materials.h"
+#include "headers/renderer_sky.h"
+
+static GLuint skyTexture = 0;
+
+//Unit cube around the eye, the vertex doubles as the cube map direction
+static const float skyFaces[6][4][3] =
+{
+	{ { 1, -1,  1}, { 1, -1, -1}, { 1,  1, -1}, { 1,  1,  1} },
+	{ {-1, -1, -1}, {-1, -1,  1}, {-1,  1,  1}, {-1,  1, -1} },
+	{ {-1,  1,  1}, { 1,  1,  1}, { 1,  1, -1}, {-1,  1, -1} },
+	{ {-1, -1, -1}, { 1, -1, -1}, { 1, -1,  1}, {-1, -1,  1} },
+	{ {-1, -1,  1}, { 1, -1,  1}, { 1,  1,  1}, {-1,  1,  1} },
+	{ { 1, -1, -1}, {-1, -1, -1}, {-1,  1, -1}, { 1,  1, -1} }
+};
+
+/*
+ * renderer_sky_loadCubemap
+ * Uploads all six faces into a single cube map texture and returns it,
+ * replacing the old sky. They all have to be square and the same size.
+ * Returns 0 (and leaves the old sky alone) if any of them can't be used.
+ */
+int renderer_sky_loadCubemap(char *faces[6])
+{
+	int		i, size;
+	GLuint	type, texture;
+	image_t	images[6];
+
+	for(i = 0; i < 6; i++)
+	{
+		if(!renderer_img_decodeTGA(faces[i], &images[i]))
+			break;
+
+		renderer_img_applyQuality(&images[i]);
+
+		if(images[i].width != images[i].height || images[i].width != images[0].width)
+		{
+			printf("Loading sky: %s, failed. Faces must be square and the same size.\n", faces[i]);
+			renderer_img_freeImage(&images[i]);
+			break;
+		}
+	}
+
+	if(i < 6)
+	{
+		while(--i >= 0)
+			renderer_img_freeImage(&images[i]);
+		return 0;
+	}
+
+	size = images[0].width;
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	for(i = 0; i < 6; i++)
+	{
+		type = (images[i].bpp == 24) ? GL_RGB : GL_RGBA;
+
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, size, size,
+				0, type, GL_UNSIGNED_BYTE, images[i].data);
+
+		renderer_img_freeImage(&images[i]);
+	}
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+	if(skyTexture)
+		glDeleteTextures(1, &skyTexture);
+
+	skyTexture = texture;
+	return texture;
+}
+
+/*
+ * renderer_sky_draw
+ * Render command callback, the argument is the cube map to draw. Expects
+ * a rotation-only modelview. Must come after the opaque geometry, and
+ * leaves depth writes alone.
+ */
+void renderer_sky_draw(int texture)
+{
+	int i, j;
+
+	if(!texture)
+		return;
+
+	glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT | GL_VIEWPORT_BIT | GL_TEXTURE_BIT | GL_CURRENT_BIT);
+
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_TEXTURE_CUBE_MAP);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+
+	//Everything lands exactly on the far plane, so only uncovered pixels
+	//(still at the cleared depth) pass
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+	glDepthRange(1.0, 1.0);
+
+	glColor3f(1.0, 1.0, 1.0);
+
+	glBegin(GL_QUADS);
+	for(i = 0; i < 6; i++)
+	{
+		for(j = 0; j < 4; j++)
+		{
+			glTexCoord3fv(skyFaces[i][j]);
+			glVertex3fv(skyFaces[i][j]);
+		}
+	}
+	glEnd();
+
+	glPopAttrib();
+}
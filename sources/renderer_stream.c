@@ -0,0 +1,203 @@
+/*
+===========================================================================
+File:		renderer_stream.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Streaming vertex buffer for geometry that changes every frame.
+			Everything a frame streams is written in one go, then drawn
+			from with as many draw calls as it needs.
+
+			With buffer storage, one buffer three segments long is mapped
+			once for good, and each frame writes into the next segment
+			after waiting on the fence from the last time it was used.
+			Otherwise the buffer is orphaned each frame and refilled with
+			a single glBufferSubData. Without buffer objects at all it
+			falls back on client-side arrays.
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/files.h"
+
+#include "headers/renderer_glext.h"
+#include "headers/renderer_stream.h"
+
+#define SEGMENT_BYTES (STREAM_SEGMENT_VERTS * sizeof(streamVertex_t))
+
+//How long to wait on a fence before asking again, in nanoseconds
+#define FENCE_TIMEOUT 1000000
+
+static GLuint			vbo = 0;
+static eboolean			persistent = efalse;
+static streamVertex_t	*mapped = NULL;
+
+//Used by the orphaning and client array paths
+static streamVertex_t	*staging = NULL;
+
+static GLsync			fences[STREAM_SEGMENTS];
+static int				segment = 0;
+
+/*
+ * renderer_stream_init
+ * Call after renderer_glext_init.
+ */
+void renderer_stream_init()
+{
+	memset(fences, 0, sizeof(fences));
+	segment = 0;
+
+	if(glConfig.persistentMapping)
+	{
+		qglGenBuffers(1, &vbo);
+		qglBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+		qglBufferStorage(GL_ARRAY_BUFFER, SEGMENT_BYTES * STREAM_SEGMENTS, NULL,
+				GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+		mapped = (streamVertex_t *)qglMapBufferRange(GL_ARRAY_BUFFER, 0, SEGMENT_BYTES * STREAM_SEGMENTS,
+				GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+
+		qglBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		if(mapped != NULL)
+		{
+			persistent = etrue;
+			printf("Stream buffer: persistent, %d x %d vertices\n", STREAM_SEGMENTS, STREAM_SEGMENT_VERTS);
+			return;
+		}
+
+		//Buffers made with glBufferStorage can't be resized, start over
+		qglDeleteBuffers(1, &vbo);
+		vbo = 0;
+	}
+
+	staging = (streamVertex_t *)malloc(SEGMENT_BYTES);
+
+	if(glConfig.vertexBufferObject)
+	{
+		qglGenBuffers(1, &vbo);
+		printf("Stream buffer: orphaning, %d vertices\n", STREAM_SEGMENT_VERTS);
+	}
+	else
+		printf("Stream buffer: client arrays, %d vertices\n", STREAM_SEGMENT_VERTS);
+}
+
+/*
+ * renderer_stream_shutdown
+ */
+void renderer_stream_shutdown()
+{
+	int i;
+
+	for(i = 0; i < STREAM_SEGMENTS; i++)
+		if(fences[i] != NULL)
+			qglDeleteSync(fences[i]);
+
+	//Deleting a buffer unmaps it
+	if(vbo)
+		qglDeleteBuffers(1, &vbo);
+
+	free(staging);
+
+	vbo		   = 0;
+	mapped	   = NULL;
+	staging	   = NULL;
+	persistent = efalse;
+	memset(fences, 0, sizeof(fences));
+}
+
+/*
+ * renderer_stream_begin
+ * Returns space for this frame's vertices, at most STREAM_SEGMENT_VERTS.
+ * Only call once per frame, and follow it with renderer_stream_end.
+ */
+streamVertex_t * renderer_stream_begin(int numVerts)
+{
+	GLenum result;
+
+	if(numVerts > STREAM_SEGMENT_VERTS)
+	{
+		printf("Stream buffer: %d vertices won't fit.\n", numVerts);
+		return NULL;
+	}
+
+	if(!persistent)
+		return staging;
+
+	//Make sure the GPU is done with what was written here three frames ago
+	if(fences[segment] != NULL)
+	{
+		do
+			result = qglClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+		while(result == GL_TIMEOUT_EXPIRED);
+
+		qglDeleteSync(fences[segment]);
+		fences[segment] = NULL;
+	}
+
+	return mapped + segment * STREAM_SEGMENT_VERTS;
+}
+
+/*
+ * renderer_stream_end
+ * Coherent mappings need nothing more, otherwise this is the upload.
+ */
+void renderer_stream_end(int numVerts)
+{
+	if(persistent || !vbo)
+		return;
+
+	qglBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	//Hand the old storage back to the driver instead of waiting for the
+	//GPU to finish with it
+	qglBufferData(GL_ARRAY_BUFFER, SEGMENT_BYTES, NULL, GL_STREAM_DRAW);
+	qglBufferSubData(GL_ARRAY_BUFFER, 0, numVerts * sizeof(streamVertex_t), staging);
+
+	qglBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+ * renderer_stream_bind
+ * Sets up the vertex arrays. Leaves buffer 0 bound for anything else.
+ */
+void renderer_stream_bind()
+{
+	if(vbo)
+	{
+		qglBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glInterleavedArrays(GL_T2F_C4UB_V3F, 0, (void *)(persistent ? segment * SEGMENT_BYTES : 0));
+		qglBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	else
+		glInterleavedArrays(GL_T2F_C4UB_V3F, 0, staging);
+}
+
+/*
+ * renderer_stream_unbind
+ * The current color is undefined after drawing with a color array, so it
+ * gets put back to white.
+ */
+void renderer_stream_unbind()
+{
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	glColor4f(1.0, 1.0, 1.0, 1.0);
+}
+
+/*
+ * renderer_stream_endFrame
+ * Fences off this frame's segment and moves on to the next.
+ */
+void renderer_stream_endFrame()
+{
+	if(!persistent)
+		return;
+
+	fences[segment] = qglFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	segment = (segment + 1) % STREAM_SEGMENTS;
+}
@@ -0,0 +1,201 @@
+/*
+===========================================================================
+File:		system_headless.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+===========================================================================
+*/
+
+#include "headers/SDL/SDL_opengl.h"
+
+#include "headers/common.h"
+#include "headers/headless.h"
+
+#include <sys/time.h>
+
+//The Windows build has no EGL, so -headless isn't available there
+#ifndef _WIN32
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay	display = EGL_NO_DISPLAY;
+static EGLSurface	surface = EGL_NO_SURFACE;
+static EGLContext	context = EGL_NO_CONTEXT;
+
+/*
+ * headless_init
+ * Creates a desktop GL context with depth and stencil, rendering into an
+ * RGBA pbuffer, and makes it current on the calling thread.
+ */
+eboolean headless_init(int width, int height)
+{
+	static const EGLint configAttribs[] =
+	{
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+		EGL_RED_SIZE,			8,
+		EGL_GREEN_SIZE,			8,
+		EGL_BLUE_SIZE,			8,
+		EGL_ALPHA_SIZE,			8,
+		EGL_DEPTH_SIZE,			24,
+		EGL_STENCIL_SIZE,		8,
+		EGL_NONE
+	};
+
+	EGLint		surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+	EGLConfig	config;
+	EGLint		numConfigs;
+
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay;
+
+	display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if(display != EGL_NO_DISPLAY && !eglInitialize(display, NULL, NULL))
+		display = EGL_NO_DISPLAY;
+
+	//No display server to connect to, Mesa can still render without one
+	if(display == EGL_NO_DISPLAY)
+	{
+		getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if(getPlatformDisplay != NULL)
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+		if(display != EGL_NO_DISPLAY && !eglInitialize(display, NULL, NULL))
+			display = EGL_NO_DISPLAY;
+	}
+
+	if(display == EGL_NO_DISPLAY)
+	{
+		printf("Headless: could not open an EGL display.\n");
+		return efalse;
+	}
+
+	if(!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs < 1)
+	{
+		printf("Headless: no EGL config with a GL pbuffer.\n");
+		headless_shutdown();
+		return efalse;
+	}
+
+	surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+
+	if(surface == EGL_NO_SURFACE || !eglBindAPI(EGL_OPENGL_API))
+	{
+		printf("Headless: could not create a %dx%d pbuffer.\n", width, height);
+		headless_shutdown();
+		return efalse;
+	}
+
+	context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+
+	if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+	{
+		printf("Headless: could not make a GL context current.\n");
+		headless_shutdown();
+		return efalse;
+	}
+
+	printf("Headless: %s, %dx%d\n", (const char *)glGetString(GL_RENDERER), width, height);
+	return etrue;
+}
+
+/*
+ * headless_shutdown
+ */
+void headless_shutdown()
+{
+	if(display == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	if(context != EGL_NO_CONTEXT)
+		eglDestroyContext(display, context);
+	if(surface != EGL_NO_SURFACE)
+		eglDestroySurface(display, surface);
+
+	eglTerminate(display);
+
+	display = EGL_NO_DISPLAY;
+	surface = EGL_NO_SURFACE;
+	context = EGL_NO_CONTEXT;
+}
+
+/*
+ * headless_getProc
+ * Extension loader for renderer_glext_init.
+ */
+void * headless_getProc(const char *name)
+{
+	return (void *)eglGetProcAddress(name);
+}
+
+#else
+
+/*
+ * headless_init
+ */
+eboolean headless_init(int width, int height)
+{
+	printf("Headless: not supported on this platform, can't make a %dx%d buffer.\n", width, height);
+	return efalse;
+}
+
+/*
+ * headless_shutdown
+ */
+void headless_shutdown()
+{
+}
+
+/*
+ * headless_getProc
+ */
+void * headless_getProc(const char *name)
+{
+	return NULL;
+}
+
+#endif
+
+/*
+ * headless_seconds
+ * Wall clock time, finer than SDL_GetTicks' milliseconds.
+ */
+double headless_seconds()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/*
+ * headless_checksum
+ * FNV-1a over the RGBA contents of the framebuffer. Waits for rendering
+ * to finish.
+ */
+unsigned int headless_checksum(int width, int height)
+{
+	unsigned int	hash;
+	byte			*pixels;
+	int				i;
+
+	pixels = (byte *)malloc(width * height * 4);
+
+	glFinish();
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	hash = 2166136261u;
+	for(i = 0; i < width * height * 4; i++)
+	{
+		hash ^= pixels[i];
+		hash *= 16777619u;
+	}
+
+	free(pixels);
+	return hash;
+}
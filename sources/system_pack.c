@@ -0,0 +1,466 @@
+/*
+===========================================================================
+File:		system_pack.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Packed asset archive. One file holding every asset: a header,
+			an index of fixed size entries sorted by name, then each
+			asset's bytes starting on a PACK_ALIGN boundary. It's mapped
+			once when opened, so finding an asset is a binary search and a
+			pointer into the mapping.
+
+			Names are relative paths with forward slashes. A name that
+			isn't in the index is tried again with its leading directories
+			taken off one at a time, so absolute paths (like the ones
+			models were exported with) still find their asset.
+
+			Offsets and sizes are 32 bit, little endian.
+===========================================================================
+*/
+
+#include "headers/common.h"
+#include "headers/files.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef struct
+{
+	unsigned int	magic, version, numEntries, dataOffset;
+}
+packHeader_t;
+
+typedef struct
+{
+	char			name[PACK_MAX_NAME];
+	unsigned int	offset, size;
+}
+packEntry_t;
+
+static const byte			*packData = NULL;
+static int					packSize = 0;
+static const packEntry_t	*packIndex = NULL;
+static int					packEntries = 0;
+
+#ifdef _WIN32
+static HANDLE				packFile = INVALID_HANDLE_VALUE, packMapping = NULL;
+#endif
+
+/*
+ * pack_unmap
+ */
+static void pack_unmap()
+{
+	if(packData == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(packData);
+	CloseHandle(packMapping);
+	CloseHandle(packFile);
+
+	packFile	= INVALID_HANDLE_VALUE;
+	packMapping	= NULL;
+#else
+	munmap((void *)packData, packSize);
+#endif
+
+	packData = NULL;
+	packSize = 0;
+}
+
+/*
+ * pack_map
+ * Maps the whole file read only.
+ */
+static eboolean pack_map(const char *packName)
+{
+#ifdef _WIN32
+	packFile = CreateFileA(packName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL);
+	if(packFile == INVALID_HANDLE_VALUE)
+		return efalse;
+
+	packSize	= (int)GetFileSize(packFile, NULL);
+	packMapping	= CreateFileMappingA(packFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(packMapping != NULL)
+		packData = (const byte *)MapViewOfFile(packMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if(packData == NULL)
+	{
+		if(packMapping != NULL)
+			CloseHandle(packMapping);
+		CloseHandle(packFile);
+
+		packFile	= INVALID_HANDLE_VALUE;
+		packMapping	= NULL;
+		return efalse;
+	}
+#else
+	struct stat	st;
+	void		*mapped;
+	int			fd;
+
+	fd = open(packName, O_RDONLY);
+	if(fd < 0)
+		return efalse;
+
+	if(fstat(fd, &st) || st.st_size <= 0)
+	{
+		close(fd);
+		return efalse;
+	}
+
+	//The mapping holds on to the file by itself
+	mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(mapped == MAP_FAILED)
+		return efalse;
+
+	packData = (const byte *)mapped;
+	packSize = (int)st.st_size;
+#endif
+
+	return etrue;
+}
+
+/*
+ * files_openPack
+ * Maps an archive and checks its index, after which assets are looked for
+ * in it before anywhere else. Returns efalse if there's no archive by
+ * that name or it isn't one we can read.
+ */
+eboolean files_openPack(const char *packName)
+{
+	packHeader_t	header;
+	int				i;
+
+	files_closePack();
+
+	if(!pack_map(packName))
+		return efalse;
+
+	if(packSize < (int)sizeof(header))
+	{
+		printf("Pack: %s, failed. Too short.\n", packName);
+		pack_unmap();
+		return efalse;
+	}
+
+	memcpy(&header, packData, sizeof(header));
+
+	if(header.magic != PACK_MAGIC || header.version != PACK_VERSION ||
+	   header.numEntries > MAX_PACK_FILES ||
+	   sizeof(header) + header.numEntries * sizeof(packEntry_t) > (unsigned int)packSize)
+	{
+		printf("Pack: %s, failed. Bad header.\n", packName);
+		pack_unmap();
+		return efalse;
+	}
+
+	packIndex	= (const packEntry_t *)(packData + sizeof(header));
+	packEntries	= header.numEntries;
+
+	//Everything the lookups rely on is checked once, here
+	for(i = 0; i < packEntries; i++)
+	{
+		if(memchr(packIndex[i].name, '\0', PACK_MAX_NAME) == NULL ||
+		   packIndex[i].offset > (unsigned int)packSize ||
+		   packIndex[i].size > (unsigned int)packSize - packIndex[i].offset ||
+		   (i > 0 && strcmp(packIndex[i - 1].name, packIndex[i].name) >= 0))
+		{
+			printf("Pack: %s, failed. Index is corrupt or out of order.\n", packName);
+			pack_unmap();
+			packIndex	= NULL;
+			packEntries	= 0;
+			return efalse;
+		}
+	}
+
+	printf("Pack: %s, %d files, %d KB\n", packName, packEntries, packSize / 1024);
+	return etrue;
+}
+
+/*
+ * files_closePack
+ * Every pointer into the archive is gone after this.
+ */
+void files_closePack()
+{
+	pack_unmap();
+
+	packIndex	= NULL;
+	packEntries	= 0;
+}
+
+/*
+ * pack_compareEntry
+ */
+static int pack_compareEntry(const void *key, const void *entry)
+{
+	return strcmp((const char *)key, ((const packEntry_t *)entry)->name);
+}
+
+/*
+ * files_nextSuffix
+ * The part of a path after its first directory, NULL if there isn't one.
+ */
+static const char * files_nextSuffix(const char *path)
+{
+	const char *slash;
+
+	slash = strchr(path, '/');
+	return slash ? slash + 1 : NULL;
+}
+
+/*
+ * files_normalizeSlashes
+ */
+static void files_normalizeSlashes(const char *name, char *out, int size)
+{
+	int i;
+
+	for(i = 0; name[i] && i < size - 1; i++)
+		out[i] = (name[i] == '\\') ? '/' : name[i];
+
+	out[i] = '\0';
+}
+
+/*
+ * files_findAsset
+ * Returns the asset's bytes in the archive and sets size, or NULL if
+ * there's no archive open or the asset isn't in it. The bytes are read
+ * only and stay put until the archive is closed.
+ */
+const byte * files_findAsset(const char *name, int *size)
+{
+	char				path[MAX_FILEPATH];
+	const char			*suffix;
+	const packEntry_t	*entry;
+
+	if(packIndex == NULL)
+		return NULL;
+
+	files_normalizeSlashes(name, path, sizeof(path));
+
+	for(suffix = path; suffix != NULL; suffix = files_nextSuffix(suffix))
+	{
+		entry = (const packEntry_t *)bsearch(suffix, packIndex, packEntries, sizeof(packEntry_t), pack_compareEntry);
+
+		if(entry != NULL)
+		{
+			*size = entry->size;
+			return packData + entry->offset;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * files_openAsset
+ * fopen for an asset that isn't in the archive, trying the same shorter
+ * names the archive would.
+ */
+FILE * files_openAsset(const char *name, const char *mode)
+{
+	char		path[MAX_FILEPATH];
+	const char	*suffix;
+	FILE		*file;
+
+	file = fopen(name, mode);
+	if(file != NULL)
+		return file;
+
+	files_normalizeSlashes(name, path, sizeof(path));
+
+	for(suffix = files_nextSuffix(path); suffix != NULL; suffix = files_nextSuffix(suffix))
+	{
+		if(*suffix && (file = fopen(suffix, mode)) != NULL)
+			return file;
+	}
+
+	return NULL;
+}
+
+/*
+ * files_loadAsset
+ * An asset's bytes, out of the archive if it's there, otherwise read in
+ * from its own file. In that case allocated is set to the buffer, for the
+ * caller to free, and it has a '\0' after the last byte. Returns NULL if
+ * it couldn't be found.
+ */
+const byte * files_loadAsset(const char *name, int *size, byte **allocated)
+{
+	const byte	*data;
+	FILE		*file;
+	long		length;
+
+	*allocated = NULL;
+
+	data = files_findAsset(name, size);
+	if(data != NULL)
+		return data;
+
+	file = files_openAsset(name, "rb");
+	if(file == NULL)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	length = ftell(file);
+	rewind(file);
+
+	if(length < 0)
+	{
+		fclose(file);
+		return NULL;
+	}
+
+	*allocated = (byte *)malloc(length + 1);
+	*size = (int)fread(*allocated, 1, length, file);
+	(*allocated)[*size] = '\0';
+
+	fclose(file);
+	return *allocated;
+}
+
+/*
+ * pack_compareNames
+ */
+static int pack_compareNames(const void *a, const void *b)
+{
+	return strcmp(((const packEntry_t *)a)->name, ((const packEntry_t *)b)->name);
+}
+
+/*
+ * pack_pad
+ * Writes zeros up to the next PACK_ALIGN boundary.
+ */
+static unsigned int pack_pad(FILE *file, unsigned int offset)
+{
+	static const byte zeros[PACK_ALIGN];
+	unsigned int padding;
+
+	padding = (PACK_ALIGN - offset % PACK_ALIGN) % PACK_ALIGN;
+	fwrite(zeros, 1, padding, file);
+
+	return offset + padding;
+}
+
+/*
+ * files_writePack
+ * Packs the named files, stored under the names given, which should be
+ * relative to wherever the game is run from.
+ */
+eboolean files_writePack(const char *packName, char **names, int numNames)
+{
+	packHeader_t	header;
+	packEntry_t		*index;
+	const char		*name;
+	byte			*data;
+	unsigned int	offset;
+	int				i, size;
+	FILE			*file;
+	eboolean		ok;
+
+	if(numNames <= 0 || numNames > MAX_PACK_FILES)
+	{
+		printf("Pack: between 1 and %d files, not %d\n", MAX_PACK_FILES, numNames);
+		return efalse;
+	}
+
+	index = (packEntry_t *)calloc(numNames, sizeof(packEntry_t));
+
+	for(i = 0; i < numNames; i++)
+	{
+		name = names[i];
+		while(name[0] == '.' && (name[1] == '/' || name[1] == '\\'))
+			name += 2;
+
+		if(strlen(name) >= PACK_MAX_NAME)
+		{
+			printf("Pack: %s, name is too long\n", names[i]);
+			free(index);
+			return efalse;
+		}
+
+		files_normalizeSlashes(name, index[i].name, PACK_MAX_NAME);
+	}
+
+	qsort(index, numNames, sizeof(packEntry_t), pack_compareNames);
+
+	for(i = 1; i < numNames; i++)
+	{
+		if(!strcmp(index[i - 1].name, index[i].name))
+		{
+			printf("Pack: %s is in there twice\n", index[i].name);
+			free(index);
+			return efalse;
+		}
+	}
+
+	file = fopen(packName, "wb");
+	if(file == NULL)
+	{
+		printf("Pack: could not write %s\n", packName);
+		free(index);
+		return efalse;
+	}
+
+	//Index first, with the offsets filled in on a second pass
+	header.magic	  = PACK_MAGIC;
+	header.version	  = PACK_VERSION;
+	header.numEntries = numNames;
+	header.dataOffset = 0;
+
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(index, sizeof(packEntry_t), numNames, file);
+
+	offset = pack_pad(file, sizeof(header) + numNames * sizeof(packEntry_t));
+	header.dataOffset = offset;
+	ok = etrue;
+
+	for(i = 0; i < numNames && ok; i++)
+	{
+		data = NULL;
+
+		if(files_loadAsset(index[i].name, &size, &data) == NULL || data == NULL)
+		{
+			printf("Pack: could not read %s\n", index[i].name);
+			ok = efalse;
+			break;
+		}
+
+		index[i].offset	= offset;
+		index[i].size	= size;
+
+		fwrite(data, 1, size, file);
+		offset = pack_pad(file, offset + size);
+
+		free(data);
+	}
+
+	if(ok)
+	{
+		rewind(file);
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(index, sizeof(packEntry_t), numNames, file);
+
+		printf("Packed %d files into %s, %d KB\n", numNames, packName, offset / 1024);
+	}
+
+	fclose(file);
+	free(index);
+
+	if(!ok)
+		remove(packName);
+
+	return ok;
+}
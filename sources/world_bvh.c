@@ -0,0 +1,609 @@
+/*
+===========================================================================
+File:		world_bvh.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Scene index over everything placed in the world. It is a
+			bounding volume hierarchy built with the surface area heuristic
+			(binned, so building stays O(n log n)). Moving an object refits
+			the boxes on its path up to the root, and adding objects after
+			a build triggers a rebuild on the next query. Nothing in here
+			is thread safe, don't move things around while a recorder is
+			querying.
+===========================================================================
+*/
+
+#include "headers/common.h"
+#include "headers/files.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_models.h"
+#include "headers/world.h"
+
+#define BVH_BINS		16
+#define BVH_LEAF_SIZE	4
+#define BVH_STACK_SIZE	256
+
+//A traversal keeps at most one sibling per level on its stack, plus the two
+//children it just pushed. Nodes this deep are made leaves whatever their
+//size, so a query can never run out of stack.
+#define BVH_MAX_DEPTH	(BVH_STACK_SIZE - 2)
+
+typedef struct
+{
+	vec3_t	mins, maxs;
+	int		model, geomObject;
+	int		leaf;
+}
+worldObject_t;
+
+typedef struct
+{
+	vec3_t	mins, maxs;
+	int		parent;
+	//Interior nodes: index of the left child, the right one follows it.
+	//Leaves: first entry in objectIndices.
+	int		first;
+	//Number of objects, 0 for interior nodes
+	int		count;
+}
+bvhNode_t;
+
+static void world_buildNode(int node, int first, int count, int depth);
+
+static worldObject_t	objects[MAX_WORLD_OBJECTS];
+static int				numObjects = 0;
+
+static bvhNode_t		*nodes			= NULL;
+static int				*objectIndices	= NULL;
+static int				numNodes		= 0;
+static eboolean			needsBuild		= efalse;
+
+/*
+===========================================================================
+Helpers
+===========================================================================
+*/
+
+static void world_clearBounds(vec3_t mins, vec3_t maxs)
+{
+	mins[_X] = mins[_Y] = mins[_Z] =  1e30f;
+	maxs[_X] = maxs[_Y] = maxs[_Z] = -1e30f;
+}
+
+static void world_addBounds(vec3_t mins, vec3_t maxs, const vec3_t addMins, const vec3_t addMaxs)
+{
+	int i;
+
+	for(i = 0; i < 3; i++)
+	{
+		if(addMins[i] < mins[i]) mins[i] = addMins[i];
+		if(addMaxs[i] > maxs[i]) maxs[i] = addMaxs[i];
+	}
+}
+
+//Half of the surface area, which is all the heuristic cares about
+static float world_halfArea(const vec3_t mins, const vec3_t maxs)
+{
+	float dx = maxs[_X] - mins[_X], dy = maxs[_Y] - mins[_Y], dz = maxs[_Z] - mins[_Z];
+
+	if(dx < 0 || dy < 0 || dz < 0)
+		return 0;
+
+	return dx*dy + dy*dz + dz*dx;
+}
+
+static eboolean world_boxesOverlap(const vec3_t aMins, const vec3_t aMaxs,
+		const vec3_t bMins, const vec3_t bMaxs)
+{
+	return aMins[_X] <= bMaxs[_X] && aMaxs[_X] >= bMins[_X] &&
+		   aMins[_Y] <= bMaxs[_Y] && aMaxs[_Y] >= bMins[_Y] &&
+		   aMins[_Z] <= bMaxs[_Z] && aMaxs[_Z] >= bMins[_Z];
+}
+
+//Squared distance from a point to a box, 0 inside of it
+static float world_boxDistSquared(const vec3_t point, const vec3_t mins, const vec3_t maxs)
+{
+	int		i;
+	float	d, dist = 0;
+
+	for(i = 0; i < 3; i++)
+	{
+		if(point[i] < mins[i])
+			d = mins[i] - point[i];
+		else if(point[i] > maxs[i])
+			d = point[i] - maxs[i];
+		else
+			continue;
+
+		dist += d*d;
+	}
+
+	return dist;
+}
+
+/*
+===========================================================================
+Objects
+===========================================================================
+*/
+
+/*
+ * world_addObject
+ * Returns a handle for the new object, or -1 if the world is full.
+ */
+int world_addObject(const vec3_t mins, const vec3_t maxs, int model, int geomObject)
+{
+	worldObject_t *object;
+
+	if(numObjects >= MAX_WORLD_OBJECTS)
+	{
+		printf("World: too many objects, ignoring %d/%d.\n", model, geomObject);
+		return -1;
+	}
+
+	object = &objects[numObjects];
+
+	VectorCopy(mins, object->mins);
+	VectorCopy(maxs, object->maxs);
+	object->model		= model;
+	object->geomObject	= geomObject;
+	object->leaf		= -1;
+
+	needsBuild = etrue;
+	return numObjects++;
+}
+
+/*
+ * world_addModel
+ * Places every geom object of an ASE model at the given origin.
+ */
+void world_addModel(int model, const vec3_t origin)
+{
+	int		i;
+	vec3_t	mins, maxs;
+
+	for(i = 0; i < renderer_model_getNumObjects(model); i++)
+	{
+		renderer_model_getObjectBounds(model, i, mins, maxs);
+		VectorAdd(mins, origin, mins);
+		VectorAdd(maxs, origin, maxs);
+		world_addObject(mins, maxs, model, i);
+	}
+}
+
+/*
+ * world_moveObject
+ * Refits the boxes from the object's leaf up to the root. The tree isn't
+ * rebuilt, so if things wander far from where they started call
+ * world_build again.
+ */
+void world_moveObject(int handle, const vec3_t mins, const vec3_t maxs)
+{
+	int			i, node;
+	bvhNode_t	*n;
+
+	VectorCopy(mins, objects[handle].mins);
+	VectorCopy(maxs, objects[handle].maxs);
+
+	if(needsBuild || objects[handle].leaf < 0)
+		return;
+
+	node = objects[handle].leaf;
+	n	 = &nodes[node];
+
+	world_clearBounds(n->mins, n->maxs);
+	for(i = 0; i < n->count; i++)
+		world_addBounds(n->mins, n->maxs, objects[objectIndices[n->first + i]].mins,
+				objects[objectIndices[n->first + i]].maxs);
+
+	for(node = n->parent; node >= 0; node = nodes[node].parent)
+	{
+		n = &nodes[node];
+
+		VectorCopy(nodes[n->first].mins, n->mins);
+		VectorCopy(nodes[n->first].maxs, n->maxs);
+		world_addBounds(n->mins, n->maxs, nodes[n->first+1].mins, nodes[n->first+1].maxs);
+	}
+}
+
+int world_getNumObjects() { return numObjects; }
+
+void world_getObject(int handle, int *model, int *geomObject, vec3_t mins, vec3_t maxs)
+{
+	*model		= objects[handle].model;
+	*geomObject	= objects[handle].geomObject;
+	VectorCopy(objects[handle].mins, mins);
+	VectorCopy(objects[handle].maxs, maxs);
+}
+
+/*
+===========================================================================
+Building
+===========================================================================
+*/
+
+/*
+ * world_build
+ */
+void world_build()
+{
+	int i;
+
+	nodes		  = (bvhNode_t *)realloc(nodes, sizeof(bvhNode_t) * (2 * numObjects + 1));
+	objectIndices = (int *)realloc(objectIndices, sizeof(int) * (numObjects + 1));
+
+	for(i = 0; i < numObjects; i++)
+		objectIndices[i] = i;
+
+	numNodes		= 1;
+	nodes[0].parent	= -1;
+
+	world_buildNode(0, 0, numObjects, 0);
+
+	needsBuild = efalse;
+}
+
+/*
+ * world_makeLeaf
+ */
+static void world_makeLeaf(int node, int first, int count)
+{
+	int i;
+
+	nodes[node].first = first;
+	nodes[node].count = count;
+
+	for(i = 0; i < count; i++)
+		objects[objectIndices[first + i]].leaf = node;
+}
+
+/*
+ * world_buildNode
+ * Splits on the centroid axis with the largest spread, at whichever bin
+ * boundary minimizes area(left) * count(left) + area(right) * count(right).
+ * Lopsided splits can make the tree deep, past BVH_MAX_DEPTH whatever is
+ * left goes in one leaf.
+ */
+static void world_buildNode(int node, int first, int count, int depth)
+{
+	int			i, j, bin, axis, bestSplit, leftCount, mid, tmp, children;
+	int			binCount[BVH_BINS];
+	vec3_t		binMins[BVH_BINS], binMaxs[BVH_BINS];
+	vec3_t		cMins, cMaxs, lMins, lMaxs, rMins, rMaxs, centroid;
+	float		extent, scale, cost, bestCost, rightArea[BVH_BINS];
+	int			rightCount[BVH_BINS];
+	bvhNode_t	*n = &nodes[node];
+	worldObject_t *object;
+
+	world_clearBounds(n->mins, n->maxs);
+	world_clearBounds(cMins, cMaxs);
+
+	for(i = first; i < first + count; i++)
+	{
+		object = &objects[objectIndices[i]];
+		world_addBounds(n->mins, n->maxs, object->mins, object->maxs);
+
+		VectorAdd(object->mins, object->maxs, centroid);
+		VectorScale(centroid, 0.5f, centroid);
+		world_addBounds(cMins, cMaxs, centroid, centroid);
+	}
+
+	if(count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+	{
+		world_makeLeaf(node, first, count);
+		return;
+	}
+
+	axis = _X;
+	for(i = _Y; i <= _Z; i++)
+		if(cMaxs[i] - cMins[i] > cMaxs[axis] - cMins[axis])
+			axis = i;
+
+	extent	  = cMaxs[axis] - cMins[axis];
+	bestSplit = -1;
+
+	if(extent > 1e-6f)
+	{
+		scale = BVH_BINS / extent;
+
+		for(i = 0; i < BVH_BINS; i++)
+		{
+			binCount[i] = 0;
+			world_clearBounds(binMins[i], binMaxs[i]);
+		}
+
+		for(i = first; i < first + count; i++)
+		{
+			object = &objects[objectIndices[i]];
+
+			bin = (int)(((object->mins[axis] + object->maxs[axis]) * 0.5f - cMins[axis]) * scale);
+			if(bin >= BVH_BINS) bin = BVH_BINS - 1;
+
+			binCount[bin]++;
+			world_addBounds(binMins[bin], binMaxs[bin], object->mins, object->maxs);
+		}
+
+		//Sweep from the right to get the area/count of everything past each split
+		world_clearBounds(rMins, rMaxs);
+		rightCount[BVH_BINS-1] = 0;
+
+		for(i = BVH_BINS - 1; i > 0; i--)
+		{
+			world_addBounds(rMins, rMaxs, binMins[i], binMaxs[i]);
+			rightCount[i-1]	= rightCount[i] + binCount[i];
+			rightArea[i-1]	= world_halfArea(rMins, rMaxs);
+		}
+
+		//Then from the left, splitting after bin i
+		world_clearBounds(lMins, lMaxs);
+		leftCount = 0;
+
+		//Not splitting at all costs count * area
+		bestCost = count * world_halfArea(n->mins, n->maxs);
+
+		for(i = 0; i < BVH_BINS - 1; i++)
+		{
+			world_addBounds(lMins, lMaxs, binMins[i], binMaxs[i]);
+			leftCount += binCount[i];
+
+			if(leftCount == 0 || rightCount[i] == 0)
+				continue;
+
+			cost = leftCount * world_halfArea(lMins, lMaxs) + rightCount[i] * rightArea[i];
+
+			if(cost < bestCost)
+			{
+				bestCost  = cost;
+				bestSplit = i;
+			}
+		}
+	}
+
+	if(bestSplit >= 0)
+	{
+		//Partition in place, everything up to and including bestSplit goes left
+		i = first;
+		j = first + count - 1;
+
+		while(i <= j)
+		{
+			object = &objects[objectIndices[i]];
+
+			bin = (int)(((object->mins[axis] + object->maxs[axis]) * 0.5f - cMins[axis]) * scale);
+			if(bin >= BVH_BINS) bin = BVH_BINS - 1;
+
+			if(bin <= bestSplit)
+				i++;
+			else
+			{
+				tmp = objectIndices[i];
+				objectIndices[i] = objectIndices[j];
+				objectIndices[j--] = tmp;
+			}
+		}
+
+		mid = i;
+	}
+	else
+	{
+		//Everything is stacked on top of each other (or splitting doesn't
+		//pay off). Still split down the middle so a leaf never gets huge.
+		mid = first + count / 2;
+	}
+
+	children = numNodes;
+	numNodes += 2;
+
+	n->first = children;
+	n->count = 0;
+
+	nodes[children].parent	 = node;
+	nodes[children+1].parent = node;
+
+	world_buildNode(children,	 first, mid - first, depth + 1);
+	world_buildNode(children+1, mid,   first + count - mid, depth + 1);
+}
+
+/*
+===========================================================================
+Queries
+===========================================================================
+*/
+
+typedef eboolean (*world_nodeTest_t)(const vec3_t mins, const vec3_t maxs, const void *data);
+
+/*
+ * world_query
+ * Generic traversal, collects every object whose box passes test.
+ */
+static int world_query(world_nodeTest_t test, const void *data, int *results, int maxResults)
+{
+	int			stack[BVH_STACK_SIZE];
+	int			stackPtr, numResults, node, i, index;
+	bvhNode_t	*n;
+
+	if(needsBuild)
+		world_build();
+
+	if(numObjects == 0)
+		return 0;
+
+	numResults	= 0;
+	stackPtr	= 0;
+	stack[stackPtr++] = 0;
+
+	while(stackPtr > 0 && numResults < maxResults)
+	{
+		node = stack[--stackPtr];
+		n	 = &nodes[node];
+
+		if(!test(n->mins, n->maxs, data))
+			continue;
+
+		if(n->count > 0)
+		{
+			for(i = 0; i < n->count && numResults < maxResults; i++)
+			{
+				index = objectIndices[n->first + i];
+
+				if(test(objects[index].mins, objects[index].maxs, data))
+					results[numResults++] = index;
+			}
+		}
+		else
+		{
+			stack[stackPtr++] = n->first + 1;
+			stack[stackPtr++] = n->first;
+		}
+	}
+
+	return numResults;
+}
+
+/*
+ * world_frustumTest
+ * Box against the six planes, using the corner furthest along each
+ * plane's normal.
+ */
+static eboolean world_frustumTest(const vec3_t mins, const vec3_t maxs, const void *data)
+{
+	const float	(*planes)[4] = (const float (*)[4])data;
+	int			i;
+
+	for(i = 0; i < 6; i++)
+	{
+		if(planes[i][0] * (planes[i][0] > 0 ? maxs[_X] : mins[_X]) +
+		   planes[i][1] * (planes[i][1] > 0 ? maxs[_Y] : mins[_Y]) +
+		   planes[i][2] * (planes[i][2] > 0 ? maxs[_Z] : mins[_Z]) + planes[i][3] < 0)
+			return efalse;
+	}
+
+	return etrue;
+}
+
+/*
+ * world_queryFrustum
+ * Everything (potentially) inside of the view volume of a
+ * projection * modelview matrix.
+ */
+int world_queryFrustum(const float *mvp, int *results, int maxResults)
+{
+	float planes[6][4];
+
+	glmatrix_frustumPlanes(mvp, planes);
+
+	return world_query(world_frustumTest, planes, results, maxResults);
+}
+
+static eboolean world_boxTest(const vec3_t mins, const vec3_t maxs, const void *data)
+{
+	const float (*box)[3] = (const float (*)[3])data;
+
+	return world_boxesOverlap(mins, maxs, box[0], box[1]);
+}
+
+/*
+ * world_queryBox
+ */
+int world_queryBox(const vec3_t mins, const vec3_t maxs, int *results, int maxResults)
+{
+	vec3_t box[2];
+
+	VectorCopy(mins, box[0]);
+	VectorCopy(maxs, box[1]);
+
+	return world_query(world_boxTest, box, results, maxResults);
+}
+
+static eboolean world_sphereTest(const vec3_t mins, const vec3_t maxs, const void *data)
+{
+	const float *sphere = (const float *)data;
+
+	return world_boxDistSquared(sphere, mins, maxs) <= sphere[3] * sphere[3];
+}
+
+/*
+ * world_querySphere
+ */
+int world_querySphere(const vec3_t center, float radius, int *results, int maxResults)
+{
+	float sphere[4];
+
+	VectorCopy(center, sphere);
+	sphere[3] = radius;
+
+	return world_query(world_sphereTest, sphere, results, maxResults);
+}
+
+/*
+ * world_queryNearest
+ * Returns the object whose box is closest to point (distance 0 if point is
+ * inside of it), or -1 if nothing is within maxDist. Children are visited
+ * nearest first, so most of the tree gets pruned.
+ */
+int world_queryNearest(const vec3_t point, float maxDist, float *dist)
+{
+	int			stack[BVH_STACK_SIZE];
+	int			stackPtr, node, i, index, best, near, far;
+	float		bestDist, d, dNear, dFar;
+	bvhNode_t	*n;
+
+	if(needsBuild)
+		world_build();
+
+	best	 = -1;
+	bestDist = maxDist * maxDist;
+
+	if(numObjects == 0)
+		return -1;
+
+	stackPtr = 0;
+	stack[stackPtr++] = 0;
+
+	while(stackPtr > 0)
+	{
+		node = stack[--stackPtr];
+		n	 = &nodes[node];
+
+		if(world_boxDistSquared(point, n->mins, n->maxs) > bestDist)
+			continue;
+
+		if(n->count > 0)
+		{
+			for(i = 0; i < n->count; i++)
+			{
+				index = objectIndices[n->first + i];
+				d	  = world_boxDistSquared(point, objects[index].mins, objects[index].maxs);
+
+				if(d <= bestDist)
+				{
+					bestDist = d;
+					best	 = index;
+				}
+			}
+		}
+		else
+		{
+			near  = n->first;
+			far	  = n->first + 1;
+			dNear = world_boxDistSquared(point, nodes[near].mins, nodes[near].maxs);
+			dFar  = world_boxDistSquared(point, nodes[far].mins, nodes[far].maxs);
+
+			if(dFar < dNear)
+			{
+				near = n->first + 1;
+				far	 = n->first;
+			}
+
+			//Pushed last, popped first
+			stack[stackPtr++] = far;
+			stack[stackPtr++] = near;
+		}
+	}
+
+	if(dist != NULL)
+		*dist = (best >= 0) ? sqrt(bestDist) : maxDist;
+
+	return best;
+}
@@ -0,0 +1,78 @@
+/*
+===========================================================================
+File:		occlusion_test.c
+Author: 	James Cory Fowler
+Created on: Oct 19, 2026
+Notes:		Checks the software occlusion test against one occluder, a
+			4x4 quad 5 units in front of the camera, with a box fully
+			behind it, one sticking out past its edge, and one off to the
+			side. Needs no GL, build from the top of the tree with:
+
+			gcc -std=gnu99 -I. tests/occlusion_test.c
+				sources/renderer_occlusion.c sources/mathlib.c -lSDL -lm
+
+			Exits with 0 if everything passed.
+===========================================================================
+*/
+
+#include "headers/common.h"
+#include "headers/mathlib.h"
+
+#include "headers/renderer_occlusion.h"
+
+static const float	quadVerts[]	  = { -2.0, -2.0, -5.0,  2.0, -2.0, -5.0,  2.0, 2.0, -5.0,  -2.0, 2.0, -5.0 };
+static const int	quadIndices[] = { 0, 1, 2,  0, 2, 3 };
+
+static int failures = 0;
+
+/*
+ * test_box
+ */
+static void test_box(const char *name, const float *mvp, const vec3_t mins, const vec3_t maxs,
+		eboolean expectVisible)
+{
+	eboolean visible = renderer_occ_testBox(mvp, mins, maxs);
+
+	printf("%-24s %-8s %s\n", name, visible ? "visible" : "culled",
+			visible == expectVisible ? "ok" : "FAILED");
+
+	if(visible != expectVisible)
+		failures++;
+}
+
+int main()
+{
+	//The camera sits at the origin looking down -z, so the projection is
+	//the whole MVP
+	float	proj[16];
+	int		tested, culled;
+
+	vec3_t	hiddenMins	= { -0.5, -0.5, -9.0 }, hiddenMaxs	= { 0.5, 0.5, -8.0 };
+	vec3_t	partialMins	= {  1.5, -0.5, -9.0 }, partialMaxs	= { 4.5, 0.5, -8.0 };
+	vec3_t	visibleMins	= {  6.0, -0.5, -9.0 }, visibleMaxs	= { 7.0, 0.5, -8.0 };
+
+	glmatrix_perspective(90.0, 1.33, 0.5, 1024.0, proj);
+
+	renderer_occ_init();
+
+	//Nothing drawn yet, so nothing can be hidden
+	test_box("hidden, no occluder", proj, hiddenMins, hiddenMaxs, etrue);
+
+	renderer_occ_clear();
+	renderer_occ_drawMesh(proj, quadVerts, 4, quadIndices, 2);
+
+	test_box("fully hidden", proj, hiddenMins, hiddenMaxs, efalse);
+	test_box("partially hidden", proj, partialMins, partialMaxs, etrue);
+	test_box("visible", proj, visibleMins, visibleMaxs, etrue);
+
+	renderer_occ_getStats(&tested, &culled);
+	printf("%d tested, %d culled\n", tested, culled);
+
+	if(tested != 3 || culled != 1)
+		failures++;
+
+	if(failures)
+		printf("Occlusion test: %d failures\n", failures);
+
+	return failures ? 1 : 0;
+}